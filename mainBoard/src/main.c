@@ -5,7 +5,9 @@
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <avr/eeprom.h>
+#include <avr/wdt.h>
 #include <util/delay.h>
+#include <util/crc16.h>
 
 #define NULL ((void *)0)
 #define true 1
@@ -17,33 +19,122 @@
 #define BUTTON_ENTER 3
 
 #define TEMPERATURE_MARGIN 3
+// Temperatures are converted in 1/16 degrees C.
+#define TEMPERATURE_FRACTION_SHIFT 4
+// Gain scales the difference from this temperature, so that offset
+// and gain can be calibrated independently.
+#define CALIBRATION_PIVOT 25
+// Stored offset which represents 0 degrees C.
+#define CALIBRATION_OFFSET_ZERO 10
+#define DEFAULT_TEMPERATURE_GAIN 100
 #define ADDRESS_OFF_THRESHOLD 0
 #define ADDRESS_ON_THRESHOLD 1
 #define ADDRESS_SPIKE_WIDTH 2
 #define ADDRESS_SPIKE_HEIGHT 3
 #define ADDRESS_SPIKE_RESET 4
-
+#define ADDRESS_SATELLITE_AMOUNT 5
+#define ADDRESS_AGGREGATE 6
+#define ADDRESS_PRESTART_LEAD 7
+// Stages after the first stage use two bytes each to store off and on thresholds.
+#define ADDRESS_STAGE_THRESHOLDS 8
+#define ADDRESS_TEMPERATURE_OFFSET 12
+#define ADDRESS_TEMPERATURE_GAIN 13
+// Each fan uses two bytes to store runtime hours.
+#define ADDRESS_FAN_HOURS 32
+// Each fan uses one byte to store baseline revolutions per second.
+#define ADDRESS_FAN_BASELINES 50
+
+// Board variants may override these amounts when compiling.
+#ifndef FAN_AMOUNT
 #define FAN_AMOUNT 6
+#endif
+#if FAN_AMOUNT < 1 || FAN_AMOUNT > 6
+#error "FAN_AMOUNT must be between 1 and 6."
+#endif
 #define RUN_STATE_OFF 0
 #define RUN_STATE_ON 1
 #define RUN_STATE_SPIKE 2
-
-#define MAX_TACHOMETER_DELAY 10
+#define RUN_STATE_PRESTART 3
+// Each stage runs a larger share of the fans above its own thresholds.
+#define STAGE_AMOUNT 3
+
+// Predictions use up to 4 rise events, and need at least 3 rise events.
+#define RISE_HISTORY_LENGTH 4
+#define MIN_RISE_AMOUNT 3
+#define MIN_CYCLE_MINUTES 10
+// Rate which indicates that the hot water system is heating, about 2.5 degrees C per minute.
+#define MIN_RISE_RATE 3
+#define MIN_PREDICTION_TOLERANCE 2
+#define MAX_PREDICTION_MISSES 3
+
+#ifndef MAX_SATELLITE_AMOUNT
+#define MAX_SATELLITE_AMOUNT 4
+#endif
+#define NO_SATELLITE 0xFF
+// Satellites recognize 2 ms pulses, and their clocks may be 10% off.
+#define SATELLITE_BREAK_TIME 4000
+// Added to the address count in order to request a full message.
+#define FULL_REQUEST_OFFSET 8
+#define MESSAGE_ERROR 0
+#define MESSAGE_UNCHANGED 1
+#define MESSAGE_UPDATED 2
+#define AGGREGATE_HOTTEST 0
+#define AGGREGATE_AVERAGE 1
+// Satellite clock half-periods are multiples of this many microseconds.
+#define LINK_STEP_TIME 25
+#define LINK_LEVEL_AMOUNT 6
+// Level with 500 microsecond half-periods.
+#define DEFAULT_LINK_LEVEL 1
+#define LINK_PROBE_MESSAGES 3
+#define LINK_PROBE_MINUTES 30
+
+#define NO_FAN 0xFF
+#define ROTATION_MINUTES 60
+#define MIN_STAGE_DELAY 10
+#define MAX_STAGE_DELAY 60
+// Tachometers produce two pulses per revolution, and each pulse has two edges.
+#define MIN_SPIN_UP_EDGES 8
+#define FAN_SETTLE_TIME 3
+#define FAN_BASELINE_TIME 60
 #define MAX_TIMEOUT_DELAY 30
-#define MAX_STUCK_COUNT 5
+#define MAX_STUCK_COUNT 2
+#ifndef MAX_SPIKE_WIDTH
 #define MAX_SPIKE_WIDTH 10
+#endif
 #define MAX_HISTORY_LENGTH (MAX_SPIKE_WIDTH + 1)
 
 #define FAULT_NONE 0
 #define FAULT_TEMPERATURE 1
 #define FAULT_FAN 2
+#define FAULT_WORN 3
 
-#define TUNABLE_AMOUNT 5
-#define SCREEN_AMOUNT (1 + TUNABLE_AMOUNT)
+#define TUNABLE_AMOUNT (9 + STAGE_AMOUNT * 2)
+#define SCREEN_AMOUNT (2 + TUNABLE_AMOUNT)
 #define SCREEN_MAIN 0
+#define SCREEN_HISTORY 1
+#define FIRST_TUNABLE_SCREEN 2
+
+// History graph uses all 8 custom characters, which are 5 pixels wide.
+#define GLYPH_AMOUNT 8
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 8
+// Each sample is one minute.
+#define HISTORY_SAMPLE_AMOUNT (GLYPH_AMOUNT * GLYPH_WIDTH)
+// Temperature uses the top 7 pixel rows, and fan activity uses the bottom row.
+#define HISTORY_LEVEL_AMOUNT (GLYPH_HEIGHT - 1)
+
+#define WARM_STATE_MAGIC 0xB8EE
+// Display reset steps each wait at least this many timer ticks.
+#define LCD_RESET_TICKS 2
+#define LCD_RESET_STEP_AMOUNT 3
 
 #define TUNABLE_TEMP 0
 #define TUNABLE_TIME 1
+#define TUNABLE_COUNT 2
+#define TUNABLE_AGGREGATE 3
+#define TUNABLE_OFFSET 4
+#define TUNABLE_PERCENT 5
+#define TUNABLE_FAN 6
 
 #define sleepMilliseconds(milliseconds) _delay_ms(milliseconds)
 #define sleepMicroseconds(microseconds) _delay_us(microseconds)
@@ -73,6 +164,7 @@
 #define satelliteSckPinLow() PORTD &= ~(1 << PORTD3)
 
 #define satelliteDataPinInput() DDRD &= ~(1 << DDD4)
+#define satelliteDataPinPullUp() PORTD |= (1 << PORTD4)
 #define satelliteDataPinRead() (PIND & (1 << PIND4))
 
 #define button1PinInput() DDRD &= ~(1 << DDD5)
@@ -84,56 +176,57 @@
 #define button3PinInput() DDRD &= ~(1 << DDD7)
 #define button3PinRead() (PIND & (1 << PIND7))
 
-#define fan1ControlPinOutput() DDRC |= (1 << DDC5)
-#define fan1ControlPinInput() DDRC &= ~(1 << DDC5)
-#define fan1ControlPinHigh() PORTC |= (1 << PORTC5)
-#define fan1ControlPinLow() PORTC &= ~(1 << PORTC5)
-
-#define fan2ControlPinOutput() DDRC |= (1 << DDC4)
-#define fan2ControlPinInput() DDRC &= ~(1 << DDC4)
-#define fan2ControlPinHigh() PORTC |= (1 << PORTC4)
-#define fan2ControlPinLow() PORTC &= ~(1 << PORTC4)
-
-#define fan3ControlPinOutput() DDRC |= (1 << DDC3)
-#define fan3ControlPinInput() DDRC &= ~(1 << DDC3)
-#define fan3ControlPinHigh() PORTC |= (1 << PORTC3)
-#define fan3ControlPinLow() PORTC &= ~(1 << PORTC3)
-
-#define fan4ControlPinOutput() DDRC |= (1 << DDC0)
-#define fan4ControlPinInput() DDRC &= ~(1 << DDC0)
-#define fan4ControlPinHigh() PORTC |= (1 << PORTC0)
-#define fan4ControlPinLow() PORTC &= ~(1 << PORTC0)
-
-#define fan5ControlPinOutput() DDRC |= (1 << DDC1)
-#define fan5ControlPinInput() DDRC &= ~(1 << DDC1)
-#define fan5ControlPinHigh() PORTC |= (1 << PORTC1)
-#define fan5ControlPinLow() PORTC &= ~(1 << PORTC1)
-
-#define fan6ControlPinOutput() DDRC |= (1 << DDC2)
-#define fan6ControlPinInput() DDRC &= ~(1 << DDC2)
-#define fan6ControlPinHigh() PORTC |= (1 << PORTC2)
-#define fan6ControlPinLow() PORTC &= ~(1 << PORTC2)
-
-#define fan1TachoPinInput() DDRD &= ~(1 << DDD1)
-#define fan1TachoPinRead() (PIND & (1 << PIND1))
-
-#define fan2TachoPinInput() DDRD &= ~(1 << DDD0)
-#define fan2TachoPinRead() (PIND & (1 << PIND0))
-
-#define fan3TachoPinInput() DDRD &= ~(1 << DDD2)
-#define fan3TachoPinRead() (PIND & (1 << PIND2))
-
-#define fan4TachoPinInput() DDRB &= ~(1 << DDB2)
-#define fan4TachoPinRead() (PINB & (1 << PINB2))
-
-#define fan5TachoPinInput() DDRB &= ~(1 << DDB1)
-#define fan5TachoPinRead() (PINB & (1 << PINB1))
-
-#define fan6TachoPinInput() DDRB &= ~(1 << DDB0)
-#define fan6TachoPinRead() (PINB & (1 << PINB0))
+#define fanControlPinsOutput(mask) DDRC |= (mask)
+#define fanControlPinsInput(mask) DDRC &= ~(mask)
+#define fanControlPinsHigh(mask) PORTC |= (mask)
+#define fanControlPinsLow(mask) PORTC &= ~(mask)
+
+// Pins of each fan as `pins(index, control pin in PORTC, tachometer port,
+// tachometer pin, pin change interrupt group)`. Fans beyond FAN_AMOUNT
+// expand to nothing, so that their code and data are not compiled.
+#define FAN1_PINS(pins) pins(0, PORTC5, D, 1, 2)
+#if FAN_AMOUNT >= 2
+#define FAN2_PINS(pins) pins(1, PORTC4, D, 0, 2)
+#else
+#define FAN2_PINS(pins)
+#endif
+#if FAN_AMOUNT >= 3
+#define FAN3_PINS(pins) pins(2, PORTC3, D, 2, 2)
+#else
+#define FAN3_PINS(pins)
+#endif
+#if FAN_AMOUNT >= 4
+#define FAN4_PINS(pins) pins(3, PORTC0, B, 2, 0)
+#else
+#define FAN4_PINS(pins)
+#endif
+#if FAN_AMOUNT >= 5
+#define FAN5_PINS(pins) pins(4, PORTC1, B, 1, 0)
+#else
+#define FAN5_PINS(pins)
+#endif
+#if FAN_AMOUNT >= 6
+#define FAN6_PINS(pins) pins(5, PORTC2, B, 0, 0)
+#else
+#define FAN6_PINS(pins)
+#endif
+#define FAN_PINS(pins) FAN1_PINS(pins) FAN2_PINS(pins) FAN3_PINS(pins) \
+    FAN4_PINS(pins) FAN5_PINS(pins) FAN6_PINS(pins)
+
+#define fanControlMask(index, control, port, pin, group) 1 << control,
+#define fanTachoPinInput(index, control, port, pin, group) DDR##port &= ~(1 << pin);
+#define fanTachoPinRead(index, control, port, pin, group) \
+    if (PIN##port & (1 << pin)) { \
+        output |= (1 << index); \
+    }
+// Pin change mask bits match pin numbers in ports B and D.
+#define fanTachoInterruptEnable(index, control, port, pin, group) \
+    PCMSK##group |= (1 << pin); \
+    PCICR |= (1 << PCIE##group);
 
 #define setLcdCursorPos(posX, posY) sendLcdCommand(0x80 | (posX + posY * 0x40))
 #define clearLcd() sendLcdCommand(0x01)
+#define setLcdGlyphAddress(glyph) sendLcdCommand(0x40 | ((glyph) * GLYPH_HEIGHT))
 
 typedef struct {
     const int8_t *title; // Must be a pointer in PROGMEM.
@@ -142,52 +235,189 @@ typedef struct {
     uint8_t minValue;
     uint8_t maxValue;
     void (*save)(void);
+    // Only used by stage threshold screens.
+    uint8_t stage;
 } tunableScreen_t;
 
+// Control state which survives resets other than power-on reset.
+typedef struct {
+    uint16_t magic;
+    uint8_t runState;
+    uint8_t activeStages;
+    uint8_t runningFanAmount;
+    uint8_t enabledFans;
+    // Fan hours are only saved to EEPROM when an hour has passed.
+    uint8_t fanMinutes[FAN_AMOUNT];
+    uint8_t currentTemperature;
+    uint8_t satelliteTemperatures[MAX_SATELLITE_AMOUNT];
+    uint8_t temperatureHistory[MAX_HISTORY_LENGTH];
+    uint8_t historyLength;
+    uint8_t spikeCooldown;
+    uint16_t uptimeMinutes;
+    uint16_t lastRiseMinute;
+    uint16_t riseMinutes[RISE_HISTORY_LENGTH];
+    uint8_t riseAmount;
+    uint8_t predictionMisses;
+    // Misses move the prediction past the one derived from rise events.
+    uint16_t predictedMinute;
+    uint16_t crc;
+} warmState_t;
+
 const int8_t lcdInitCommands[] PROGMEM = {
     0x39, 0x1C, 0x52, 0x69, 0x74, 0x38, 0x0C, 0x01, 0x06
 };
 
-const int8_t idleText[] PROGMEM = "Idle   ";
-const int8_t runningText[] PROGMEM = "Running";
-const int8_t spikeText[] PROGMEM = "Spike  ";
-const int8_t offThresholdText[] PROGMEM = "Off threshold:";
-const int8_t onThresholdText[] PROGMEM = "On threshold:";
+// Control pin of each fan in PORTC.
+const uint8_t fanControlMasks[FAN_AMOUNT] PROGMEM = {
+    FAN_PINS(fanControlMask)
+};
+
+// Number of link steps in each half-period of the satellite clock,
+// from slowest to fastest. Half-periods must stay well below 2 ms,
+// which satellites interpret as the start or end of addressing.
+const uint8_t linkHalfPeriods[LINK_LEVEL_AMOUNT] PROGMEM = {
+    40, 20, 10, 5, 3, 2
+};
+const int8_t idleText[] PROGMEM = "Idle    ";
+const int8_t stageText[] PROGMEM = "Stage ";
+const int8_t spikeText[] PROGMEM = "Spike   ";
+const int8_t prestartText[] PROGMEM = "Prestart";
+const int8_t stageOffTexts[STAGE_AMOUNT][13] PROGMEM = {
+    "Stage 1 off:", "Stage 2 off:", "Stage 3 off:"
+};
+const int8_t stageOnTexts[STAGE_AMOUNT][12] PROGMEM = {
+    "Stage 1 on:", "Stage 2 on:", "Stage 3 on:"
+};
+// Default off and on thresholds of each stage.
+const uint8_t defaultStageThresholds[STAGE_AMOUNT * 2] PROGMEM = {
+    29, 32, 35, 38, 42, 45
+};
 const int8_t spikeWidthText[] PROGMEM = "Spike width:";
 const int8_t spikeHeightText[] PROGMEM = "Spike height:";
 const int8_t spikeResetText[] PROGMEM = "Spike reset:";
-const int8_t healthyText[] PROGMEM = "Healthy     ";
-const int8_t tempFaultText[] PROGMEM = "Temp fault! ";
+const int8_t prestartLeadText[] PROGMEM = "Prestart lead:";
+const int8_t satelliteAmountText[] PROGMEM = "Satellites:";
+const int8_t aggregateText[] PROGMEM = "Aggregate:";
+const int8_t temperatureOffsetText[] PROGMEM = "Temp offset:";
+const int8_t temperatureGainText[] PROGMEM = "Temp gain:";
+const int8_t replaceFanText[] PROGMEM = "Replace fan:";
+const int8_t noneText[] PROGMEM = "None ";
+const int8_t hottestText[] PROGMEM = "Hottest";
+const int8_t averageText[] PROGMEM = "Average";
+const int8_t healthyText[] PROGMEM = "Healthy      ";
+const int8_t tempFaultText[] PROGMEM = "Temp fault!  ";
+const int8_t tempText[] PROGMEM = "Temp ";
+const int8_t tempsText[] PROGMEM = "Temps ";
 const int8_t fanText[] PROGMEM = "Fan ";
+const int8_t fansText[] PROGMEM = "Fans ";
 const int8_t faultText[] PROGMEM = " fault!";
+const int8_t wornText[] PROGMEM = "Worn: ";
+const int8_t historyText[] PROGMEM = "Last 40m";
+
+// Must be in the noinit section, so that C runtime does not clear the values.
+uint8_t resetFlags __attribute__((section(".noinit")));
+warmState_t warmState __attribute__((section(".noinit")));
 
 uint8_t lastSatelliteData = 0;
 uint8_t lastPressedButton = BUTTON_NONE;
 uint8_t buttonIsPressed = false;
 uint8_t secondDelay = 0;
-uint8_t fanDelay = 0;
-uint8_t tachometerDelay = 0;
-uint8_t stuckDelay = 0;
+uint8_t stageDelay = MAX_STAGE_DELAY;
+uint8_t healthDelay = 0;
+uint8_t warmStateDelay = 0;
+uint8_t lcdDelay = 0;
 uint8_t timeoutDelay = 0;
 uint8_t minuteDelay = 0;
+uint8_t runtimeDelay = 0;
+uint8_t historyDelay = 0;
+uint8_t uptimeDelay = 0;
 
 uint8_t hasTemperatureFault = false;
 uint8_t currentTemperature = 0;
-uint8_t offThreshold;
-uint8_t onThreshold;
+// Aggregated rate of satellites, in the same unit as `satelliteRates`.
+int8_t currentRate = 0;
+uint8_t satelliteAmount;
+uint8_t aggregateMode;
+uint8_t pollingSatellite = 0;
+uint8_t selectedSatellite = NO_SATELLITE;
+uint8_t linkLevel = DEFAULT_LINK_LEVEL;
+uint16_t linkProbeMinute = 0;
+uint16_t messageTemperatureV;
+int8_t messageRate;
+// Most recent temperature in each full message.
+uint8_t satelliteReadings[MAX_SATELLITE_AMOUNT];
+uint8_t satelliteTemperatures[MAX_SATELLITE_AMOUNT];
+// Change in quarter ADC values during about 8.4 seconds.
+int8_t satelliteRates[MAX_SATELLITE_AMOUNT];
+uint8_t satelliteFaults = 0;
+// Bit n is set when satellite n must send a full message.
+uint8_t satelliteRequests = 0xFF;
+// Stored with CALIBRATION_OFFSET_ZERO added.
+uint8_t temperatureOffset;
+// Percent of the nominal TMP36 slope.
+uint8_t temperatureGain;
+// Gain multiplied by 256, which is computed when the gain is loaded or saved.
+uint16_t temperatureGainScale;
+uint8_t stageOffThresholds[STAGE_AMOUNT];
+uint8_t stageOnThresholds[STAGE_AMOUNT];
+// Bit n is set when stage n + 1 is active.
+uint8_t activeStages = 0;
 uint8_t spikeWidth;
 uint8_t spikeHeight;
 uint8_t spikeResetTime;
 uint8_t runState = RUN_STATE_OFF;
+uint8_t prestartLead;
+uint16_t uptimeMinutes = 0;
+// Minute when temperature last rose at MIN_RISE_RATE or faster.
+uint16_t lastRiseMinute = 0;
+// Most recent rise event is first.
+uint16_t riseMinutes[RISE_HISTORY_LENGTH];
+uint8_t riseAmount = 0;
+uint8_t hasPrediction = false;
+uint16_t predictedMinute;
+uint16_t predictionPeriod;
+uint16_t predictionTolerance;
+uint8_t predictionMisses = 0;
 uint8_t runningFanAmount = 0;
+// Bit n is set when fan n + 1 is enabled.
+uint8_t enabledFans = 0;
+uint8_t lastStartedFan = NO_FAN;
+uint16_t fanHours[FAN_AMOUNT];
+uint8_t fanMinutes[FAN_AMOUNT];
+uint8_t lastTachometers = 0;
+// Tachometer edges of the last started fan since it was switched on.
+uint8_t spinUpEdgeCount = 0;
+uint16_t tachometerCounts[FAN_AMOUNT];
 uint8_t stuckCounts[FAN_AMOUNT];
-uint8_t stuckFan = 0;
+// Number of seconds which each fan has been running, up to FAN_BASELINE_TIME.
+uint8_t fanRunTimes[FAN_AMOUNT];
+// Tachometer edges per second of each fan, multiplied by 16.
+uint16_t fanSpeeds[FAN_AMOUNT];
+// Revolutions per second of each fan while healthy, or 0xFF when not learned.
+uint8_t fanBaselines[FAN_AMOUNT];
+// Number of the fan to replace in the tunable screen, or 0 for none.
+uint8_t replacedFan = 0;
+uint8_t faultedFans = 0;
+uint8_t wornFans = 0;
 uint8_t currentFault = FAULT_NONE;
+uint8_t currentFaultMask = 0;
 uint8_t temperatureHistory[MAX_HISTORY_LENGTH];
 uint8_t historyLength = 0;
+// Samples for the history screen, where the most recent sample is first.
+// Temperature is 0 when unknown.
+uint8_t historyTemperatures[HISTORY_SAMPLE_AMOUNT];
+uint8_t fanHistory[HISTORY_SAMPLE_AMOUNT];
+uint8_t historyHasChanged = true;
+// Pixel rows of each custom character in display memory.
+uint8_t uploadedGlyphs[GLYPH_AMOUNT * GLYPH_HEIGHT];
+uint8_t glyphsAreUploaded = false;
+uint8_t historyMinTemperature;
+uint8_t historyMaxTemperature;
 uint8_t spikeCooldown = 0;
 
 tunableScreen_t tunableScreens[TUNABLE_AMOUNT];
+uint8_t lcdIsReady = false;
+uint8_t lcdStartupStep = 0;
 uint8_t currentScreen;
 tunableScreen_t *currentTunable;
 uint8_t isEditingTunable = false;
@@ -196,51 +426,30 @@ uint8_t heartbeat = 0;
 
 uint8_t displayedTemperature;
 uint8_t displayedRunState;
+uint8_t displayedStage;
 uint8_t displayedHeartbeat;
 uint8_t displayedFault;
+uint8_t displayedFaultMask;
+
+// Runs before C runtime initialization, because the watchdog
+// remains enabled with a short timeout after a watchdog reset.
+void readResetFlags(void) __attribute__((naked, used, section(".init3")));
+void readResetFlags(void) {
+    resetFlags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
 
-void controlFans(uint8_t enableAmount) {
-    if (enableAmount >= 1) {
-        fan1ControlPinHigh();
-        fan1ControlPinOutput();
-    } else {
-        fan1ControlPinLow();
-        fan1ControlPinInput();
-    }
-    if (enableAmount >= 2) {
-        fan4ControlPinHigh();
-        fan4ControlPinOutput();
-    } else {
-        fan4ControlPinLow();
-        fan4ControlPinInput();
-    }
-    if (enableAmount >= 3) {
-        fan2ControlPinHigh();
-        fan2ControlPinOutput();
-    } else {
-        fan2ControlPinLow();
-        fan2ControlPinInput();
-    }
-    if (enableAmount >= 4) {
-        fan5ControlPinHigh();
-        fan5ControlPinOutput();
-    } else {
-        fan5ControlPinLow();
-        fan5ControlPinInput();
-    }
-    if (enableAmount >= 5) {
-        fan3ControlPinHigh();
-        fan3ControlPinOutput();
-    } else {
-        fan3ControlPinLow();
-        fan3ControlPinInput();
-    }
-    if (enableAmount >= 6) {
-        fan6ControlPinHigh();
-        fan6ControlPinOutput();
-    } else {
-        fan6ControlPinLow();
-        fan6ControlPinInput();
+void controlFans(uint8_t fans) {
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        uint8_t mask = pgm_read_byte(fanControlMasks + index);
+        if (fans & (1 << index)) {
+            fanControlPinsHigh(mask);
+            fanControlPinsOutput(mask);
+        } else {
+            fanControlPinsLow(mask);
+            fanControlPinsInput(mask);
+        }
     }
 }
 
@@ -258,6 +467,7 @@ void initializePinModes() {
     satelliteSckPinHigh();
     satelliteSckPinOutput();
     satelliteDataPinInput();
+    satelliteDataPinPullUp();
     
     button1PinInput();
     button2PinInput();
@@ -265,12 +475,7 @@ void initializePinModes() {
     
     controlFans(0);
     
-    fan1TachoPinInput();
-    fan2TachoPinInput();
-    fan3TachoPinInput();
-    fan4TachoPinInput();
-    fan5TachoPinInput();
-    fan6TachoPinInput();
+    FAN_PINS(fanTachoPinInput)
 }
 
 void sendLcdInt8(int8_t data) {
@@ -300,18 +505,10 @@ void sendLcdCharacter(int8_t character) {
     sleepMilliseconds(2);
 }
 
-void initializeLcd() {
-    
-    sleepMilliseconds(20);
-    lcdResetPinLow();
-    sleepMilliseconds(20);
-    lcdResetPinHigh();
-    sleepMilliseconds(20);
-    lcdCsPinLow();
-    
-    for (int8_t index = 0; index < sizeof(lcdInitCommands); index++) {
-        int8_t command = pgm_read_byte(lcdInitCommands + index);
-        sendLcdCommand(command);
+void sleepLinkHalfPeriod() {
+    uint8_t stepAmount = pgm_read_byte(linkHalfPeriods + linkLevel);
+    for (uint8_t count = 0; count < stepAmount; count++) {
+        sleepMicroseconds(LINK_STEP_TIME);
     }
 }
 
@@ -319,10 +516,10 @@ uint8_t readSatelliteRun() {
     uint8_t runLength = 1;
     while (runLength < 4) {
         satelliteSckPinLow();
-        sleepMicroseconds(500);
+        sleepLinkHalfPeriod();
         satelliteSckPinHigh();
         uint8_t currentData = satelliteDataPinRead();
-        sleepMicroseconds(500);
+        sleepLinkHalfPeriod();
         if (currentData != lastSatelliteData) {
             lastSatelliteData = currentData;
             break;
@@ -332,7 +529,37 @@ uint8_t readSatelliteRun() {
     return runLength;
 }
 
-uint16_t readTemperatureV() {
+// Addressing always uses the default rate, because a miscounted pulse
+// would select the wrong satellite.
+void pulseSatelliteSck() {
+    satelliteSckPinLow();
+    sleepMicroseconds(500);
+    satelliteSckPinHigh();
+    sleepMicroseconds(500);
+}
+
+void selectSatellite(uint8_t satellite, uint8_t shouldRequestFull) {
+    // Hold SCK low so that all satellites release the data line.
+    satelliteSckPinLow();
+    sleepMicroseconds(SATELLITE_BREAK_TIME);
+    satelliteSckPinHigh();
+    sleepMicroseconds(500);
+    uint8_t pulseAmount = satellite + 1;
+    if (shouldRequestFull) {
+        pulseAmount += FULL_REQUEST_OFFSET;
+    }
+    for (uint8_t count = 0; count < pulseAmount; count++) {
+        pulseSatelliteSck();
+    }
+    // Hold SCK high so that the addressed satellite takes the data line.
+    sleepMicroseconds(SATELLITE_BREAK_TIME);
+    lastSatelliteData = 0;
+    selectedSatellite = satellite;
+}
+
+// Reads temperature and rate into `messageTemperatureV` and `messageRate`
+// when the message is a full message.
+uint8_t readSatelliteMessage() {
     // Wait for run length 3, which occurs at the start of a message.
     uint8_t count = 0;
     while (true) {
@@ -342,50 +569,48 @@ uint16_t readTemperatureV() {
         }
         if (runLength > 3) {
             // Run length above 3 is not possible under normal circumstances.
-            return 0;
+            return MESSAGE_ERROR;
         }
         count += 1;
-        if (count > 20) {
+        if (count > 25) {
             // We failed to find the start of a message.
-            return 0;
+            return MESSAGE_ERROR;
         }
     }
-    // Allow ADC to run on satellite.
-    sleepMilliseconds(4);
+    uint8_t runLength = readSatelliteRun();
+    if (runLength == 1) {
+        return MESSAGE_UNCHANGED;
+    }
+    if (runLength > 2) {
+        return MESSAGE_ERROR;
+    }
     uint16_t temperatureV = 0;
-    for (uint8_t offset = 0; offset < 10; offset++) {
+    uint8_t rate = 0;
+    for (uint8_t offset = 0; offset < 18; offset++) {
         uint8_t runLength = readSatelliteRun();
         if (runLength == 2) {
-            temperatureV |= ((uint16_t)1 << offset);
+            if (offset < 10) {
+                temperatureV |= ((uint16_t)1 << offset);
+            } else {
+                rate |= (1 << (offset - 10));
+            }
         }
         if (runLength > 2) {
             // Run lengths in payload must be 1 or 2.
-            return 0;
+            return MESSAGE_ERROR;
         }
     }
-    return temperatureV;
+    if (temperatureV == 0) {
+        return MESSAGE_ERROR;
+    }
+    messageTemperatureV = temperatureV;
+    messageRate = (int8_t)rate;
+    return MESSAGE_UPDATED;
 }
 
 uint8_t readTachometers() {
     uint8_t output = 0;
-    if (fan1TachoPinRead()) {
-        output |= 0x01;
-    }
-    if (fan2TachoPinRead()) {
-        output |= 0x02;
-    }
-    if (fan3TachoPinRead()) {
-        output |= 0x04;
-    }
-    if (fan4TachoPinRead()) {
-        output |= 0x08;
-    }
-    if (fan5TachoPinRead()) {
-        output |= 0x10;
-    }
-    if (fan6TachoPinRead()) {
-        output |= 0x20;
-    }
+    FAN_PINS(fanTachoPinRead)
     return output;
 }
 
@@ -401,6 +626,37 @@ uint8_t getPressedButton() {
     }
 }
 
+void initializeTachometers() {
+    lastTachometers = readTachometers();
+    FAN_PINS(fanTachoInterruptEnable)
+}
+
+void handleTachometerChange() {
+    uint8_t currentTachometers = readTachometers();
+    uint8_t changes = currentTachometers ^ lastTachometers;
+    lastTachometers = currentTachometers;
+    if (lastStartedFan != NO_FAN && (changes & (1 << lastStartedFan))
+            && spinUpEdgeCount < 0xFF) {
+        spinUpEdgeCount += 1;
+    }
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        if ((changes & (1 << index)) && tachometerCounts[index] < 0xFFFF) {
+            tachometerCounts[index] += 1;
+        }
+    }
+}
+
+// Interrupts triggered by fan tachometers.
+#if FAN_AMOUNT >= 4
+ISR(PCINT0_vect) {
+    handleTachometerChange();
+}
+#endif
+
+ISR(PCINT2_vect) {
+    handleTachometerChange();
+}
+
 void initializeTimer() {
     // Enable CTC timer mode, and use clock divided by 1024.
     TCCR1B |= (1 << WGM12) | (1 << CS02) | (1 << CS00);
@@ -422,13 +678,16 @@ ISR(TIMER1_COMPA_vect) {
     if (buttonIsPressed && !lastButtonIsPressed) {
         lastPressedButton = pressedButton;
     }
+    if (stageDelay < MAX_STAGE_DELAY) {
+        stageDelay += 1;
+    }
+    warmStateDelay = 1;
+    if (lcdDelay < LCD_RESET_TICKS) {
+        lcdDelay += 1;
+    }
     secondDelay += 1;
     if (secondDelay >= 20) {
-        fanDelay += 1;
-        if (tachometerDelay < MAX_TACHOMETER_DELAY) {
-            tachometerDelay += 1;
-        }
-        stuckDelay = 1;
+        healthDelay = 1;
         if (timeoutDelay < MAX_TIMEOUT_DELAY) {
             timeoutDelay += 1;
         }
@@ -436,29 +695,223 @@ ISR(TIMER1_COMPA_vect) {
         if (minuteDelay < 60) {
             minuteDelay += 1;
         }
+        if (runtimeDelay < 60) {
+            runtimeDelay += 1;
+        }
+        if (historyDelay < 60) {
+            historyDelay += 1;
+        }
+        if (uptimeDelay < 60) {
+            uptimeDelay += 1;
+        }
         secondDelay = 0;
     }
 }
 
+uint8_t readEeprom(uint8_t address) {
+    eeprom_busy_wait();
+    return eeprom_read_byte((uint8_t *)(uint16_t)address);
+}
+
+void writeEeprom(uint8_t address, uint8_t value) {
+    eeprom_busy_wait();
+    eeprom_write_byte((uint8_t *)(uint16_t)address, value);
+}
+
+uint16_t readEepromWord(uint8_t address) {
+    eeprom_busy_wait();
+    return eeprom_read_word((uint16_t *)(uint16_t)address);
+}
+
+void writeEepromWord(uint8_t address, uint16_t value) {
+    eeprom_busy_wait();
+    eeprom_write_word((uint16_t *)(uint16_t)address, value);
+}
+
+uint8_t convertTemperature(uint16_t temperatureV) {
+    // TMP36 outputs 500 mV at 0 degrees C and 10 mV per degree C, and ADC
+    // reference is 5 V, so each ADC value is 125/16 of 1/16 degree C.
+    int32_t temperature = (((int32_t)temperatureV * 125) >> 4) - (50 << TEMPERATURE_FRACTION_SHIFT);
+    temperature -= CALIBRATION_PIVOT << TEMPERATURE_FRACTION_SHIFT;
+    temperature = (temperature * temperatureGainScale) >> 8;
+    temperature += (CALIBRATION_PIVOT + (int8_t)(temperatureOffset - CALIBRATION_OFFSET_ZERO))
+        << TEMPERATURE_FRACTION_SHIFT;
+    // Round to whole degrees.
+    temperature = (temperature + (1 << (TEMPERATURE_FRACTION_SHIFT - 1))) >> TEMPERATURE_FRACTION_SHIFT;
+    // Zero indicates a missing temperature.
+    if (temperature < 1) {
+        return 1;
+    }
+    if (temperature > 0xFF) {
+        return 0xFF;
+    }
+    return (uint8_t)temperature;
+}
+
+void updateSatelliteTemperature(uint8_t satellite) {
+    uint8_t mask = (1 << satellite);
+    uint8_t shouldRequestFull = ((satelliteRequests & mask) > 0);
+    if (satellite != selectedSatellite || shouldRequestFull) {
+        selectSatellite(satellite, shouldRequestFull);
+    }
+    uint8_t result = readSatelliteMessage();
+    if (result == MESSAGE_ERROR) {
+        // Errors from a healthy satellite indicate that the link is too fast.
+        if ((satelliteFaults & mask) == 0 && linkLevel > 0) {
+            linkLevel -= 1;
+        }
+        // Select the satellite again during the next attempt,
+        // and request a full message in case we missed an update.
+        selectedSatellite = NO_SATELLITE;
+        satelliteRequests |= mask;
+        satelliteFaults |= mask;
+        satelliteTemperatures[satellite] = 0;
+        return;
+    }
+    if (result == MESSAGE_UPDATED) {
+        satelliteReadings[satellite] = convertTemperature(messageTemperatureV);
+        satelliteRates[satellite] = messageRate;
+        satelliteRequests &= ~mask;
+    } else if (shouldRequestFull) {
+        // The satellite ignored our request.
+        return;
+    }
+    satelliteFaults &= ~mask;
+    uint8_t temperatureC = satelliteReadings[satellite];
+    uint8_t temperature = satelliteTemperatures[satellite];
+    if (temperature == 0) {
+        temperature = temperatureC;
+    }
+    if (temperatureC < temperature - TEMPERATURE_MARGIN) {
+        temperature -= 1;
+    }
+    if (temperatureC > temperature + TEMPERATURE_MARGIN) {
+        temperature += 1;
+    }
+    satelliteTemperatures[satellite] = temperature;
+}
+
+// Returns whether the satellite sends clean full messages at the current link rate.
+uint8_t probeLink(uint8_t satellite) {
+    uint8_t output = true;
+    for (uint8_t count = 0; count < LINK_PROBE_MESSAGES; count++) {
+        selectSatellite(satellite, true);
+        if (readSatelliteMessage() != MESSAGE_UPDATED) {
+            output = false;
+            break;
+        }
+    }
+    // The probe consumed updates, so request another full message.
+    satelliteRequests |= (1 << satellite);
+    return output;
+}
+
+// Returns whether all satellites in the mask send clean full messages at the current link rate.
+uint8_t probeLinks(uint8_t satelliteMask) {
+    for (uint8_t satellite = 0; satellite < satelliteAmount; satellite++) {
+        if ((satelliteMask & (1 << satellite)) > 0 && !probeLink(satellite)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finds the fastest link rate at which all responding satellites send clean messages.
+void calibrateLink() {
+    linkProbeMinute = uptimeMinutes;
+    linkLevel = 0;
+    uint8_t satelliteMask = 0;
+    for (uint8_t satellite = 0; satellite < satelliteAmount; satellite++) {
+        if (probeLink(satellite)) {
+            satelliteMask |= (1 << satellite);
+        }
+    }
+    if (satelliteMask == 0) {
+        linkLevel = DEFAULT_LINK_LEVEL;
+        return;
+    }
+    while (linkLevel < LINK_LEVEL_AMOUNT - 1) {
+        linkLevel += 1;
+        if (!probeLinks(satelliteMask)) {
+            linkLevel -= 1;
+            break;
+        }
+    }
+}
+
+// Periodically tries a faster link rate, since errors may have
+// caused a fall back to a slower rate.
+void updateLinkRate() {
+    if ((uint16_t)(uptimeMinutes - linkProbeMinute) < LINK_PROBE_MINUTES) {
+        return;
+    }
+    linkProbeMinute = uptimeMinutes;
+    if (linkLevel >= LINK_LEVEL_AMOUNT - 1) {
+        return;
+    }
+    uint8_t satelliteMask = ((1 << satelliteAmount) - 1) & ~satelliteFaults;
+    if (satelliteMask == 0) {
+        return;
+    }
+    linkLevel += 1;
+    if (!probeLinks(satelliteMask)) {
+        linkLevel -= 1;
+    }
+}
+
 void updateTemperature() {
-    uint16_t temperatureV = readTemperatureV();
-    hasTemperatureFault = (temperatureV == 0);
+    // Read one satellite during each iteration of the main loop.
+    if (pollingSatellite >= satelliteAmount) {
+        pollingSatellite = 0;
+    }
+    updateSatelliteTemperature(pollingSatellite);
+    pollingSatellite += 1;
+    // Aggregate temperatures of satellites which have been read successfully.
+    uint8_t healthyAmount = 0;
+    uint16_t totalTemperature = 0;
+    int16_t totalRate = 0;
+    uint8_t hottestTemperature = 0;
+    int8_t hottestRate = 0;
+    for (uint8_t satellite = 0; satellite < satelliteAmount; satellite++) {
+        uint8_t temperature = satelliteTemperatures[satellite];
+        if (temperature == 0) {
+            continue;
+        }
+        healthyAmount += 1;
+        totalTemperature += temperature;
+        totalRate += satelliteRates[satellite];
+        if (temperature > hottestTemperature) {
+            hottestTemperature = temperature;
+            hottestRate = satelliteRates[satellite];
+        }
+    }
+    hasTemperatureFault = (healthyAmount == 0);
     if (hasTemperatureFault) {
         currentTemperature = 0;
-        return;
-    }
-    // At 25 degrees C, voltage = 750 mV = 153.6 ADC value
-    // Increase of 1 degree C = 10 mV = 2.05 ADC value
-    uint8_t temperatureC = (uint8_t)(25 + ((int16_t)temperatureV - 154) / 2);
-    if (currentTemperature == 0) {
-        currentTemperature = temperatureC;
+        currentRate = 0;
+    } else if (aggregateMode == AGGREGATE_AVERAGE) {
+        currentTemperature = totalTemperature / healthyAmount;
+        currentRate = totalRate / healthyAmount;
+    } else {
+        currentTemperature = hottestTemperature;
+        currentRate = hottestRate;
     }
-    if (temperatureC < currentTemperature - TEMPERATURE_MARGIN) {
-        currentTemperature -= 1;
+}
+
+// Returns whether the current rate would raise temperature by the spike height
+// within the spike width, and temperature has already risen by half as much.
+uint8_t rateIndicatesSpike() {
+    if (historyLength == 0 || currentRate <= 0) {
+        return false;
     }
-    if (temperatureC > currentTemperature + TEMPERATURE_MARGIN) {
-        currentTemperature += 1;
+    // One rate unit is about 5/6 degrees C per minute.
+    if ((int16_t)currentRate * spikeWidth * 5 < (int16_t)spikeHeight * 6) {
+        return false;
     }
+    uint8_t refIndex = (historyLength > spikeWidth) ? spikeWidth : historyLength - 1;
+    uint8_t refTemperature = temperatureHistory[refIndex];
+    return (currentTemperature > refTemperature
+        && (currentTemperature - refTemperature) * 2 >= spikeHeight);
 }
 
 void updateSpike() {
@@ -481,104 +934,386 @@ void updateSpike() {
         }
         minuteDelay = 0;
     }
-    if (isInCooldown || spikeWidth >= historyLength) {
+    if (isInCooldown) {
         return;
     }
-    uint8_t refTemperature = temperatureHistory[spikeWidth];
-    // Be careful of unsigned integers.
-    if (currentTemperature > refTemperature
-            && currentTemperature - refTemperature >= spikeHeight) {
+    uint8_t isSpike = rateIndicatesSpike();
+    if (spikeWidth < historyLength) {
+        uint8_t refTemperature = temperatureHistory[spikeWidth];
+        // Be careful of unsigned integers.
+        if (currentTemperature > refTemperature
+                && currentTemperature - refTemperature >= spikeHeight) {
+            isSpike = true;
+        }
+    }
+    if (isSpike) {
         spikeCooldown = spikeResetTime;
         historyLength = 0;
         minuteDelay = 0;
     }
 }
 
+void updateHistory() {
+    if (historyDelay < 60) {
+        return;
+    }
+    historyDelay = 0;
+    for (uint8_t index = HISTORY_SAMPLE_AMOUNT - 1; index > 0; index--) {
+        historyTemperatures[index] = historyTemperatures[index - 1];
+        fanHistory[index] = fanHistory[index - 1];
+    }
+    historyTemperatures[0] = currentTemperature;
+    fanHistory[0] = runningFanAmount;
+    historyHasChanged = true;
+}
+
+// Fans with lower priority are started first and stopped last.
+uint32_t getFanPriority(uint8_t index) {
+    uint32_t output = (uint32_t)fanHours[index] * 60 + fanMinutes[index];
+    if (faultedFans & (1 << index)) {
+        // Start faulted fans last, and stop them first.
+        output |= 0x80000000;
+    }
+    return output;
+}
+
+// Returns the stopped fan with the lowest priority if `shouldStart` is true,
+// or the running fan with the highest priority otherwise.
+uint8_t selectFan(uint8_t shouldStart) {
+    uint8_t output = NO_FAN;
+    uint32_t outputPriority = 0;
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        uint8_t isEnabled = ((enabledFans & (1 << index)) > 0);
+        if (isEnabled == shouldStart) {
+            continue;
+        }
+        uint32_t priority = getFanPriority(index);
+        if (output == NO_FAN || (shouldStart && priority < outputPriority)
+                || (!shouldStart && priority > outputPriority)) {
+            output = index;
+            outputPriority = priority;
+        }
+    }
+    return output;
+}
+
+// Determines whether a running fan has accumulated enough runtime
+// beyond a stopped fan that the two should be swapped. Faulted running
+// fans are always swapped for healthy stopped fans.
+uint8_t shouldRotateFans() {
+    if (runningFanAmount == 0 || runningFanAmount >= FAN_AMOUNT) {
+        return false;
+    }
+    uint32_t stopPriority = getFanPriority(selectFan(false));
+    uint32_t startPriority = getFanPriority(selectFan(true));
+    return (stopPriority >= startPriority + ROTATION_MINUTES);
+}
+
+// Predicts the next rise event when the intervals between recent
+// rise events are consistent.
+void updatePrediction() {
+    hasPrediction = false;
+    if (riseAmount < MIN_RISE_AMOUNT) {
+        return;
+    }
+    uint8_t intervalAmount = riseAmount - 1;
+    uint16_t period = (uint16_t)(riseMinutes[0] - riseMinutes[intervalAmount]) / intervalAmount;
+    uint16_t tolerance = period >> 3;
+    if (tolerance < MIN_PREDICTION_TOLERANCE) {
+        tolerance = MIN_PREDICTION_TOLERANCE;
+    }
+    for (uint8_t index = 0; index < intervalAmount; index++) {
+        uint16_t interval = riseMinutes[index] - riseMinutes[index + 1];
+        // Be careful of unsigned integers.
+        if (interval + tolerance < period || interval > period + tolerance) {
+            return;
+        }
+    }
+    predictionPeriod = period;
+    predictionTolerance = tolerance;
+    predictedMinute = riseMinutes[0] + period;
+    hasPrediction = true;
+}
+
+void recordRiseEvent() {
+    if (hasPrediction) {
+        int16_t error = (int16_t)(uptimeMinutes - predictedMinute);
+        if (error >= -(int16_t)predictionTolerance && error <= (int16_t)predictionTolerance) {
+            predictionMisses = 0;
+        }
+    }
+    for (uint8_t index = RISE_HISTORY_LENGTH - 1; index > 0; index--) {
+        riseMinutes[index] = riseMinutes[index - 1];
+    }
+    riseMinutes[0] = uptimeMinutes;
+    if (riseAmount < RISE_HISTORY_LENGTH) {
+        riseAmount += 1;
+    }
+    updatePrediction();
+}
+
+// Records a rise event when temperature starts rising quickly, regardless
+// of whether the fans are running.
+void updateRiseEvents() {
+    if (hasTemperatureFault || currentRate < MIN_RISE_RATE) {
+        return;
+    }
+    // Temperature rose recently, so this is the same heating cycle.
+    if (riseAmount == 0 || (uint16_t)(uptimeMinutes - lastRiseMinute) >= MIN_CYCLE_MINUTES) {
+        recordRiseEvent();
+    }
+    lastRiseMinute = uptimeMinutes;
+}
+
+void updateUptime() {
+    if (uptimeDelay < 60) {
+        return;
+    }
+    uptimeDelay = 0;
+    uptimeMinutes += 1;
+    if (!hasPrediction) {
+        return;
+    }
+    int16_t error = (int16_t)(uptimeMinutes - predictedMinute);
+    if (error <= (int16_t)predictionTolerance) {
+        return;
+    }
+    // The predicted rise did not occur, so stop pre-starting fans until
+    // a prediction is confirmed again.
+    predictionMisses += 1;
+    if (predictionMisses >= MAX_PREDICTION_MISSES) {
+        riseAmount = 0;
+        predictionMisses = 0;
+        hasPrediction = false;
+    } else {
+        predictedMinute += predictionPeriod;
+    }
+}
+
+uint8_t prestartIsDue() {
+    if (!hasPrediction || predictionMisses > 0 || prestartLead == 0) {
+        return false;
+    }
+    int16_t error = (int16_t)(uptimeMinutes - predictedMinute);
+    return (error >= -(int16_t)prestartLead && error <= (int16_t)predictionTolerance);
+}
+
+// Returns the number of fans which run during the given 1-based stage.
+uint8_t getStageFanAmount(uint8_t stage) {
+    // Round up, so that every stage runs at least one fan.
+    return (FAN_AMOUNT * stage + STAGE_AMOUNT - 1) / STAGE_AMOUNT;
+}
+
+// Returns the highest active 1-based stage, or 0 when no stage is active.
+uint8_t getCurrentStage() {
+    uint8_t output = 0;
+    for (uint8_t stage = 0; stage < STAGE_AMOUNT; stage++) {
+        if (activeStages & (1 << stage)) {
+            output = stage + 1;
+        }
+    }
+    return output;
+}
+
+// Each stage has its own hysteresis between off and on thresholds.
+void updateStages() {
+    for (uint8_t stage = 0; stage < STAGE_AMOUNT; stage++) {
+        uint8_t mask = (1 << stage);
+        if (currentTemperature <= stageOffThresholds[stage]) {
+            activeStages &= ~mask;
+        }
+        if (currentTemperature >= stageOnThresholds[stage]) {
+            activeStages |= mask;
+        }
+    }
+}
+
 void updateFans() {
     if (hasTemperatureFault) {
         runState = RUN_STATE_OFF;
     } else if (spikeCooldown > 0) {
         runState = RUN_STATE_SPIKE;
     } else {
-        if (currentTemperature <= offThreshold) {
+        if (runState == RUN_STATE_PRESTART) {
             runState = RUN_STATE_OFF;
         }
-        if (currentTemperature >= onThreshold) {
+        updateStages();
+        if (activeStages > 0) {
             runState = RUN_STATE_ON;
+        } else if (runState == RUN_STATE_ON || currentTemperature <= stageOffThresholds[0]) {
+            runState = RUN_STATE_OFF;
+        }
+        if (runState == RUN_STATE_OFF && prestartIsDue()) {
+            runState = RUN_STATE_PRESTART;
         }
     }
-    if (fanDelay < 5) {
+    if (stageDelay < MIN_STAGE_DELAY) {
         return;
     }
-    fanDelay = 0;
+    uint8_t targetFanAmount;
     if (runState == RUN_STATE_OFF) {
-        if (runningFanAmount > 0) {
-            runningFanAmount -= 1;
-        }
+        targetFanAmount = 0;
+    } else if (runState == RUN_STATE_ON) {
+        targetFanAmount = getStageFanAmount(getCurrentStage());
+    } else if (runState == RUN_STATE_PRESTART) {
+        targetFanAmount = getStageFanAmount(1);
     } else {
-        if (runningFanAmount < FAN_AMOUNT) {
-            runningFanAmount += 1;
+        targetFanAmount = FAN_AMOUNT;
+    }
+    if (runningFanAmount == targetFanAmount && shouldRotateFans()) {
+        // Start the least used fan, after which the most used fan will stop.
+        targetFanAmount += 1;
+    }
+    if (runningFanAmount == targetFanAmount) {
+        return;
+    }
+    if (targetFanAmount > runningFanAmount) {
+        // Wait for the last fan to spin up before starting another fan,
+        // unless its tachometer has stayed flat for too long.
+        if (lastStartedFan != NO_FAN && stageDelay < MAX_STAGE_DELAY
+                && spinUpEdgeCount < MIN_SPIN_UP_EDGES) {
+            return;
         }
+        uint8_t fan = selectFan(true);
+        enabledFans |= (1 << fan);
+        controlFans(enabledFans);
+        // Discard edges which were caused by switching the fan on.
+        cli();
+        lastStartedFan = fan;
+        spinUpEdgeCount = 0;
+        sei();
+        runningFanAmount += 1;
+    } else {
+        uint8_t fan = selectFan(false);
+        enabledFans &= ~(1 << fan);
+        controlFans(enabledFans);
+        lastStartedFan = NO_FAN;
+        runningFanAmount -= 1;
     }
-    controlFans(runningFanAmount);
+    stageDelay = 0;
 }
 
-void updateTachometers() {
-    
-    // Only measure tachometers after all fans have been running for a little while.
-    if (runningFanAmount < FAN_AMOUNT) {
-        tachometerDelay = 0;
+void updateFanRuntime() {
+    if (runtimeDelay < 60) {
         return;
     }
-    if (tachometerDelay < MAX_TACHOMETER_DELAY) {
+    runtimeDelay = 0;
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        if (!(enabledFans & (1 << index))) {
+            continue;
+        }
+        fanMinutes[index] += 1;
+        if (fanMinutes[index] < 60) {
+            continue;
+        }
+        fanMinutes[index] = 0;
+        if (fanHours[index] < 0xFFFE) {
+            fanHours[index] += 1;
+            writeEepromWord(ADDRESS_FAN_HOURS + index * 2, fanHours[index]);
+        }
+    }
+}
+
+void updateFanTrend(uint8_t index, uint16_t count) {
+    // Keep the speed within 16 bits.
+    if (count > 0x0FFF) {
+        count = 0x0FFF;
+    }
+    if (fanRunTimes[index] <= FAN_SETTLE_TIME + 1) {
+        fanSpeeds[index] = count << 4;
+    } else {
+        // Exponential moving average with weight 1/8.
+        fanSpeeds[index] += (count << 1) - (fanSpeeds[index] >> 3);
+    }
+    if (fanRunTimes[index] < FAN_BASELINE_TIME) {
         return;
     }
-    
-    // Detect which tachometers change during 100 ms.
-    uint8_t changedTachometers = 0;
-    uint8_t startTachometers = readTachometers();
-    for (uint8_t count = 0; count < 20; count++) {
-        sleepMilliseconds(5);
-        uint8_t currentTachometers = readTachometers();
-        changedTachometers |= currentTachometers ^ startTachometers;
-        if (changedTachometers == (uint8_t)~(0xFF << FAN_AMOUNT)) {
-            break;
-        }
+    uint8_t baseline = fanBaselines[index];
+    if (baseline == 0xFF) {
+        // Learn the speed of a healthy fan once, so that wear can be
+        // detected over the lifetime of the fan.
+        // Each revolution produces four tachometer edges.
+        uint16_t revolutions = fanSpeeds[index] >> 6;
+        baseline = (revolutions < 0xFF) ? revolutions : 0xFE;
+        fanBaselines[index] = baseline;
+        writeEeprom(ADDRESS_FAN_BASELINES + index, baseline);
+    }
+    // Fan is worn below 75% of baseline speed, and recovers above 81%.
+    uint16_t speed = fanSpeeds[index];
+    uint8_t mask = (1 << index);
+    if (speed < (uint16_t)baseline * 48) {
+        wornFans |= mask;
+    } else if (speed >= (uint16_t)baseline * 52) {
+        wornFans &= ~mask;
+    }
+}
+
+void updateTachometers() {
+    if (healthDelay == 0) {
+        return;
     }
+    healthDelay = 0;
     
-    // Update stuck counts of tachometers.
-    uint8_t shouldCountStuck = (stuckDelay > 0);
-    stuckDelay = 0;
+    // Collect tachometer edges during the last second.
+    uint16_t counts[FAN_AMOUNT];
+    cli();
     for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
-        if (changedTachometers & (1 << index)) {
-            stuckCounts[index] = 0;
-        } else if (shouldCountStuck && stuckCounts[index] < MAX_STUCK_COUNT) {
-            stuckCounts[index] += 1;
-        }
+        counts[index] = tachometerCounts[index];
+        tachometerCounts[index] = 0;
     }
+    sei();
     
-    // Determine if any fan is stuck.
-    stuckFan = 0;
+    // Only check fans which are running, after they have spun up.
+    // Faults of stopped fans persist until the fans run again.
     for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
-        if (stuckCounts[index] >= MAX_STUCK_COUNT) {
-            stuckFan = index + 1;
-            break;
+        uint8_t mask = (1 << index);
+        if (!(enabledFans & mask)) {
+            fanRunTimes[index] = 0;
+            continue;
+        }
+        if (fanRunTimes[index] < FAN_BASELINE_TIME) {
+            fanRunTimes[index] += 1;
+        }
+        if (fanRunTimes[index] <= FAN_SETTLE_TIME) {
+            continue;
+        }
+        uint16_t count = counts[index];
+        if (count == 0) {
+            if (stuckCounts[index] < MAX_STUCK_COUNT) {
+                stuckCounts[index] += 1;
+            }
+            if (stuckCounts[index] >= MAX_STUCK_COUNT) {
+                faultedFans |= mask;
+            }
+            // Restart trend measurement when the fan recovers.
+            fanRunTimes[index] = FAN_SETTLE_TIME;
+        } else {
+            stuckCounts[index] = 0;
+            faultedFans &= ~mask;
+            updateFanTrend(index, count);
         }
     }
 }
 
 void updateFault() {
-    if (hasTemperatureFault) {
+    uint8_t temperatureFaults = satelliteFaults & ~(0xFF << satelliteAmount);
+    if (hasTemperatureFault || temperatureFaults > 0) {
         currentFault = FAULT_TEMPERATURE;
-    } else if (stuckFan > 0) {
-        currentFault = FAULT_FAN + stuckFan - 1;
+        currentFaultMask = temperatureFaults;
+    } else if (faultedFans > 0) {
+        currentFault = FAULT_FAN;
+        currentFaultMask = faultedFans;
+    } else if (wornFans > 0) {
+        currentFault = FAULT_WORN;
+        currentFaultMask = wornFans;
     } else {
         currentFault = FAULT_NONE;
+        currentFaultMask = 0;
     }
 }
 
 // `text` must be a pointer in PROGMEM.
-void displayText(uint8_t posX, uint8_t posY, const uint8_t *text) {
+uint8_t displayText(uint8_t posX, uint8_t posY, const uint8_t *text) {
     setLcdCursorPos(posX, posY);
     uint8_t index = 0;
     while (true) {
@@ -589,6 +1324,7 @@ void displayText(uint8_t posX, uint8_t posY, const uint8_t *text) {
         sendLcdCharacter(character);
         index += 1;
     }
+    return index;
 }
 
 uint8_t displayInt(uint8_t value) {
@@ -635,11 +1371,65 @@ void displayTime(uint8_t posX, uint8_t posY, uint8_t time) {
     }
 }
 
+void displayCount(uint8_t posX, uint8_t posY, uint8_t count) {
+    setLcdCursorPos(posX, posY);
+    uint8_t offsetX = displayInt(count);
+    while (offsetX < 3) {
+        sendLcdCharacter(' ');
+        offsetX += 1;
+    }
+}
+
+void displayOffset(uint8_t posX, uint8_t posY, uint8_t offset) {
+    setLcdCursorPos(posX, posY);
+    uint8_t offsetX = 1;
+    if (offset < CALIBRATION_OFFSET_ZERO) {
+        sendLcdCharacter('-');
+        offsetX += displayInt(CALIBRATION_OFFSET_ZERO - offset);
+    } else {
+        sendLcdCharacter('+');
+        offsetX += displayInt(offset - CALIBRATION_OFFSET_ZERO);
+    }
+    sendLcdCharacter(0xF2); // Degree symbol.
+    sendLcdCharacter('C');
+    offsetX += 2;
+    while (offsetX < 6) {
+        sendLcdCharacter(' ');
+        offsetX += 1;
+    }
+}
+
+void displayPercent(uint8_t posX, uint8_t posY, uint8_t percent) {
+    setLcdCursorPos(posX, posY);
+    uint8_t offsetX = displayInt(percent);
+    sendLcdCharacter('%');
+    offsetX += 1;
+    while (offsetX < 4) {
+        sendLcdCharacter(' ');
+        offsetX += 1;
+    }
+}
+
 void displayTunable(uint8_t tunableType, uint8_t value) {
     if (tunableType == TUNABLE_TEMP) {
         displayTemperature(2, 1, value);
     } else if (tunableType == TUNABLE_TIME) {
         displayTime(2, 1, value);
+    } else if (tunableType == TUNABLE_COUNT) {
+        displayCount(2, 1, value);
+    } else if (tunableType == TUNABLE_AGGREGATE) {
+        displayText(2, 1, (value == AGGREGATE_AVERAGE) ? averageText : hottestText);
+    } else if (tunableType == TUNABLE_OFFSET) {
+        displayOffset(2, 1, value);
+    } else if (tunableType == TUNABLE_PERCENT) {
+        displayPercent(2, 1, value);
+    } else if (tunableType == TUNABLE_FAN) {
+        if (value == 0) {
+            displayText(2, 1, noneText);
+        } else {
+            displayText(2, 1, fanText);
+            sendLcdCharacter('0' + value);
+        }
     }
 }
 
@@ -653,9 +1443,15 @@ void displayRunState() {
     if (runState == RUN_STATE_OFF) {
         text = idleText;
     } else if (runState == RUN_STATE_ON) {
-        text = runningText;
+        uint8_t stage = getCurrentStage();
+        displayText(8, 0, stageText);
+        sendLcdCharacter('0' + stage);
+        sendLcdCharacter(' ');
+        displayedStage = stage;
     } else if (runState == RUN_STATE_SPIKE) {
         text = spikeText;
+    } else if (runState == RUN_STATE_PRESTART) {
+        text = prestartText;
     }
     if (text != NULL) {
         displayText(8, 0, text);
@@ -670,18 +1466,161 @@ void displayHeartbeat() {
     displayedHeartbeat = heartbeat;
 }
 
+// Displays the 1-based number of each bit in `mask`, and returns the number of characters.
+uint8_t displayMaskNumbers(uint8_t mask) {
+    uint8_t output = 0;
+    for (uint8_t index = 0; index < 8; index++) {
+        if (mask & (1 << index)) {
+            sendLcdCharacter('1' + index);
+            output += 1;
+        }
+    }
+    return output;
+}
+
 void displayFault() {
     if (currentFault == FAULT_NONE) {
         displayText(2, 1, healthyText);
-    } else if (currentFault == FAULT_TEMPERATURE) {
+    } else if (currentFault == FAULT_TEMPERATURE && satelliteAmount <= 1) {
         displayText(2, 1, tempFaultText);
-    } else if (currentFault >= FAULT_FAN) {
-        uint8_t fanIndex = currentFault - FAULT_FAN;
-        displayText(2, 1, fanText);
-        sendLcdCharacter('1' + fanIndex);
-        displayText(7, 1, faultText);
+    } else {
+        // Multiple bits are set when multiple fans or satellites have failed.
+        uint8_t isSingle = !(currentFaultMask & (currentFaultMask - 1));
+        const uint8_t *text;
+        if (currentFault == FAULT_WORN) {
+            text = wornText;
+        } else if (currentFault == FAULT_TEMPERATURE) {
+            text = isSingle ? tempText : tempsText;
+        } else {
+            text = isSingle ? fanText : fansText;
+        }
+        uint8_t offsetX = displayText(2, 1, text);
+        offsetX += displayMaskNumbers(currentFaultMask);
+        if (currentFault != FAULT_WORN) {
+            if (isSingle) {
+                offsetX += displayText(2 + offsetX, 1, faultText);
+            } else {
+                sendLcdCharacter('!');
+                offsetX += 1;
+            }
+        }
+        while (offsetX < 13) {
+            sendLcdCharacter(' ');
+            offsetX += 1;
+        }
     }
     displayedFault = currentFault;
+    displayedFaultMask = currentFaultMask;
+}
+
+void updateHistoryScale() {
+    uint8_t minTemperature = 0xFF;
+    uint8_t maxTemperature = 0;
+    for (uint8_t index = 0; index < HISTORY_SAMPLE_AMOUNT; index++) {
+        uint8_t temperature = historyTemperatures[index];
+        if (temperature == 0) {
+            continue;
+        }
+        if (temperature < minTemperature) {
+            minTemperature = temperature;
+        }
+        if (temperature > maxTemperature) {
+            maxTemperature = temperature;
+        }
+    }
+    if (maxTemperature == 0) {
+        minTemperature = 0;
+    } else if (maxTemperature - minTemperature < HISTORY_LEVEL_AMOUNT - 1) {
+        // Each pixel represents at least 1 degree C.
+        maxTemperature = minTemperature + HISTORY_LEVEL_AMOUNT - 1;
+    }
+    historyMinTemperature = minTemperature;
+    historyMaxTemperature = maxTemperature;
+}
+
+// Returns one pixel row of a custom character in the history graph,
+// where bit 4 is the leftmost pixel.
+uint8_t getHistoryGlyphRow(uint8_t glyph, uint8_t row) {
+    uint8_t output = 0;
+    for (uint8_t column = 0; column < GLYPH_WIDTH; column++) {
+        output <<= 1;
+        // Oldest sample is on the left.
+        uint8_t index = HISTORY_SAMPLE_AMOUNT - 1 - (glyph * GLYPH_WIDTH + column);
+        if (row == HISTORY_LEVEL_AMOUNT) {
+            if (fanHistory[index] > 0) {
+                output |= 1;
+            }
+            continue;
+        }
+        uint8_t temperature = historyTemperatures[index];
+        if (temperature == 0) {
+            continue;
+        }
+        // Bar height is between 1 and HISTORY_LEVEL_AMOUNT pixels.
+        uint8_t level = (uint16_t)(temperature - historyMinTemperature)
+            * (HISTORY_LEVEL_AMOUNT - 1)
+            / (historyMaxTemperature - historyMinTemperature);
+        if (row >= HISTORY_LEVEL_AMOUNT - 1 - level) {
+            output |= 1;
+        }
+    }
+    return output;
+}
+
+// Uploads custom characters whose pixels have changed since the last upload.
+void updateHistoryGlyphs() {
+    for (uint8_t glyph = 0; glyph < GLYPH_AMOUNT; glyph++) {
+        uint8_t *uploadedRows = uploadedGlyphs + glyph * GLYPH_HEIGHT;
+        uint8_t rows[GLYPH_HEIGHT];
+        uint8_t hasChanged = !glyphsAreUploaded;
+        for (uint8_t row = 0; row < GLYPH_HEIGHT; row++) {
+            rows[row] = getHistoryGlyphRow(glyph, row);
+            if (rows[row] != uploadedRows[row]) {
+                hasChanged = true;
+            }
+        }
+        if (!hasChanged) {
+            continue;
+        }
+        setLcdGlyphAddress(glyph);
+        for (uint8_t row = 0; row < GLYPH_HEIGHT; row++) {
+            sendLcdCharacter(rows[row]);
+            uploadedRows[row] = rows[row];
+        }
+    }
+    glyphsAreUploaded = true;
+}
+
+void displayHistoryScale() {
+    displayTemperature(9, 0, historyMaxTemperature);
+    displayTemperature(9, 1, historyMinTemperature);
+}
+
+void displayHistory() {
+    updateHistoryScale();
+    updateHistoryGlyphs();
+    setLcdCursorPos(0, 0);
+    for (uint8_t glyph = 0; glyph < GLYPH_AMOUNT; glyph++) {
+        sendLcdCharacter(glyph);
+    }
+    displayText(0, 1, historyText);
+    displayHistoryScale();
+    historyHasChanged = false;
+}
+
+void updateHistoryScreen() {
+    if (!historyHasChanged) {
+        return;
+    }
+    uint8_t lastMinTemperature = historyMinTemperature;
+    uint8_t lastMaxTemperature = historyMaxTemperature;
+    updateHistoryScale();
+    updateHistoryGlyphs();
+    if (historyMinTemperature != lastMinTemperature
+            || historyMaxTemperature != lastMaxTemperature) {
+        displayHistoryScale();
+    }
+    historyHasChanged = false;
 }
 
 void displayEditCursor() {
@@ -700,65 +1639,107 @@ void showScreen(uint8_t screen) {
         displayRunState();
         displayHeartbeat();
         displayFault();
+    } else if (currentScreen == SCREEN_HISTORY) {
+        displayHistory();
     } else {
-        currentTunable = tunableScreens + currentScreen - 1;
+        currentTunable = tunableScreens + currentScreen - FIRST_TUNABLE_SCREEN;
         displayText(0, 0, currentTunable->title);
         uint8_t value = *(currentTunable->valuePointer);
         displayTunable(currentTunable->tunableType, value);
     }
 }
 
+// Brings up the display one step during each iteration of the main loop,
+// so that fan control does not wait for the display.
+void updateLcdStartup() {
+    if (lcdIsReady) {
+        return;
+    }
+    if (lcdStartupStep < LCD_RESET_STEP_AMOUNT) {
+        if (lcdDelay < LCD_RESET_TICKS) {
+            return;
+        }
+        lcdDelay = 0;
+        if (lcdStartupStep == 0) {
+            lcdResetPinLow();
+        } else if (lcdStartupStep == 1) {
+            lcdResetPinHigh();
+        } else {
+            lcdCsPinLow();
+        }
+        lcdStartupStep += 1;
+        return;
+    }
+    uint8_t index = lcdStartupStep - LCD_RESET_STEP_AMOUNT;
+    int8_t command = pgm_read_byte(lcdInitCommands + index);
+    sendLcdCommand(command);
+    lcdStartupStep += 1;
+    if (index >= sizeof(lcdInitCommands) - 1) {
+        lcdIsReady = true;
+        showScreen(SCREEN_MAIN);
+    }
+}
+
 void checkTimeout() {
-    if (currentScreen != SCREEN_MAIN && timeoutDelay >= MAX_TIMEOUT_DELAY) {
+    if (currentScreen >= FIRST_TUNABLE_SCREEN && timeoutDelay >= MAX_TIMEOUT_DELAY) {
         showScreen(SCREEN_MAIN);
     }
 }
 
 void updateScreen() {
+    if (!lcdIsReady) {
+        return;
+    }
+    if (currentScreen == SCREEN_HISTORY) {
+        updateHistoryScreen();
+        return;
+    }
     if (currentScreen != SCREEN_MAIN) {
         return;
     }
     if (currentTemperature != displayedTemperature) {
         displayCurrentTemp();
     }
-    if (runState != displayedRunState) {
+    if (runState != displayedRunState
+            || (runState == RUN_STATE_ON && getCurrentStage() != displayedStage)) {
         displayRunState();
     }
     if (heartbeat != displayedHeartbeat) {
         displayHeartbeat();
     }
-    if (currentFault != displayedFault) {
+    if (currentFault != displayedFault || currentFaultMask != displayedFaultMask) {
         displayFault();
     }
 }
 
-uint8_t readEeprom(uint8_t address) {
-    eeprom_busy_wait();
-    return eeprom_read_byte((uint8_t *)(uint16_t)address);
-}
-
-void writeEeprom(uint8_t address, uint8_t value) {
-    eeprom_busy_wait();
-    eeprom_write_byte((uint8_t *)(uint16_t)address, value);
+// Returns the address of the off threshold, which is followed by the on threshold.
+uint8_t getStageThresholdAddress(uint8_t stage) {
+    if (stage == 0) {
+        return ADDRESS_OFF_THRESHOLD;
+    }
+    return ADDRESS_STAGE_THRESHOLDS + (stage - 1) * 2;
 }
 
-void saveThresholds() {
-    writeEeprom(ADDRESS_OFF_THRESHOLD, offThreshold);
-    writeEeprom(ADDRESS_ON_THRESHOLD, onThreshold);
+void saveStageThresholds(uint8_t stage) {
+    uint8_t address = getStageThresholdAddress(stage);
+    writeEeprom(address, stageOffThresholds[stage]);
+    writeEeprom(address + 1, stageOnThresholds[stage]);
 }
 
-void saveOffThreshold() {
-    if (onThreshold <= offThreshold) {
-        onThreshold = offThreshold + 1;
+void saveStageOffThreshold() {
+    uint8_t stage = currentTunable->stage;
+    if (stageOnThresholds[stage] <= stageOffThresholds[stage]) {
+        stageOnThresholds[stage] = stageOffThresholds[stage] + 1;
     }
-    saveThresholds();
+    saveStageThresholds(stage);
 }
 
-void saveOnThreshold() {
-    if (offThreshold >= onThreshold) {
-        offThreshold = onThreshold - 1;
+void saveStageOnThreshold() {
+    uint8_t stage = currentTunable->stage;
+    if (stageOffThresholds[stage] >= stageOnThresholds[stage]) {
+        stageOffThresholds[stage] = stageOnThresholds[stage] - 1;
     }
-    saveThresholds();
+    saveStageThresholds(stage);
 }
 
 void saveSpikeWidth() {
@@ -773,24 +1754,79 @@ void saveSpikeReset() {
     writeEeprom(ADDRESS_SPIKE_RESET, spikeResetTime);
 }
 
+void savePrestartLead() {
+    writeEeprom(ADDRESS_PRESTART_LEAD, prestartLead);
+}
+
+void saveSatelliteAmount() {
+    for (uint8_t satellite = 0; satellite < MAX_SATELLITE_AMOUNT; satellite++) {
+        satelliteTemperatures[satellite] = 0;
+    }
+    satelliteFaults = 0;
+    satelliteRequests = 0xFF;
+    writeEeprom(ADDRESS_SATELLITE_AMOUNT, satelliteAmount);
+}
+
+void saveAggregate() {
+    writeEeprom(ADDRESS_AGGREGATE, aggregateMode);
+}
+
+void updateTemperatureGainScale() {
+    temperatureGainScale = ((uint16_t)temperatureGain * 256 + 50) / 100;
+}
+
+void saveTemperatureCalibration() {
+    updateTemperatureGainScale();
+    // Convert the next message from each satellite with the new calibration.
+    satelliteRequests = 0xFF;
+    writeEeprom(ADDRESS_TEMPERATURE_OFFSET, temperatureOffset);
+    writeEeprom(ADDRESS_TEMPERATURE_GAIN, temperatureGain);
+}
+
+// Forgets the runtime and health of a fan, after the fan has been replaced.
+void saveReplacedFan() {
+    if (replacedFan == 0) {
+        return;
+    }
+    uint8_t index = replacedFan - 1;
+    uint8_t mask = (1 << index);
+    fanHours[index] = 0;
+    fanMinutes[index] = 0;
+    writeEepromWord(ADDRESS_FAN_HOURS + index * 2, 0);
+    // Learn the baseline speed of the new fan.
+    fanBaselines[index] = 0xFF;
+    writeEeprom(ADDRESS_FAN_BASELINES + index, 0xFF);
+    fanRunTimes[index] = 0;
+    stuckCounts[index] = 0;
+    faultedFans &= ~mask;
+    wornFans &= ~mask;
+    // Show no fan the next time the screen is visited.
+    replacedFan = 0;
+}
+
 void initializeTunables() {
-    tunableScreens[0] = (tunableScreen_t){
-        offThresholdText,
-        TUNABLE_TEMP,
-        &offThreshold,
-        10,
-        90,
-        &saveOffThreshold
-    };
-    tunableScreens[1] = (tunableScreen_t){
-        onThresholdText,
-        TUNABLE_TEMP,
-        &onThreshold,
-        10,
-        90,
-        &saveOnThreshold
-    };
-    tunableScreens[2] = (tunableScreen_t){
+    for (uint8_t stage = 0; stage < STAGE_AMOUNT; stage++) {
+        tunableScreens[stage * 2] = (tunableScreen_t){
+            stageOffTexts[stage],
+            TUNABLE_TEMP,
+            stageOffThresholds + stage,
+            10,
+            90,
+            &saveStageOffThreshold,
+            stage
+        };
+        tunableScreens[stage * 2 + 1] = (tunableScreen_t){
+            stageOnTexts[stage],
+            TUNABLE_TEMP,
+            stageOnThresholds + stage,
+            10,
+            90,
+            &saveStageOnThreshold,
+            stage
+        };
+    }
+    tunableScreen_t *tunables = tunableScreens + STAGE_AMOUNT * 2;
+    tunables[0] = (tunableScreen_t){
         spikeWidthText,
         TUNABLE_TIME,
         &spikeWidth,
@@ -798,7 +1834,7 @@ void initializeTunables() {
         MAX_SPIKE_WIDTH,
         &saveSpikeWidth
     };
-    tunableScreens[3] = (tunableScreen_t){
+    tunables[1] = (tunableScreen_t){
         spikeHeightText,
         TUNABLE_TEMP,
         &spikeHeight,
@@ -806,7 +1842,7 @@ void initializeTunables() {
         90,
         &saveSpikeHeight
     };
-    tunableScreens[4] = (tunableScreen_t){
+    tunables[2] = (tunableScreen_t){
         spikeResetText,
         TUNABLE_TIME,
         &spikeResetTime,
@@ -814,11 +1850,62 @@ void initializeTunables() {
         10,
         &saveSpikeReset
     };
-    offThreshold = readEeprom(ADDRESS_OFF_THRESHOLD);
-    onThreshold = readEeprom(ADDRESS_ON_THRESHOLD);
-    if (offThreshold == 0xFF || onThreshold == 0xFF) {
-        offThreshold = 29;
-        onThreshold = 32;
+    tunables[3] = (tunableScreen_t){
+        prestartLeadText,
+        TUNABLE_TIME,
+        &prestartLead,
+        0,
+        10,
+        &savePrestartLead
+    };
+    tunables[4] = (tunableScreen_t){
+        satelliteAmountText,
+        TUNABLE_COUNT,
+        &satelliteAmount,
+        1,
+        MAX_SATELLITE_AMOUNT,
+        &saveSatelliteAmount
+    };
+    tunables[5] = (tunableScreen_t){
+        aggregateText,
+        TUNABLE_AGGREGATE,
+        &aggregateMode,
+        AGGREGATE_HOTTEST,
+        AGGREGATE_AVERAGE,
+        &saveAggregate
+    };
+    tunables[6] = (tunableScreen_t){
+        temperatureOffsetText,
+        TUNABLE_OFFSET,
+        &temperatureOffset,
+        0,
+        CALIBRATION_OFFSET_ZERO * 2,
+        &saveTemperatureCalibration
+    };
+    tunables[7] = (tunableScreen_t){
+        temperatureGainText,
+        TUNABLE_PERCENT,
+        &temperatureGain,
+        80,
+        120,
+        &saveTemperatureCalibration
+    };
+    tunables[8] = (tunableScreen_t){
+        replaceFanText,
+        TUNABLE_FAN,
+        &replacedFan,
+        0,
+        FAN_AMOUNT,
+        &saveReplacedFan
+    };
+    for (uint8_t stage = 0; stage < STAGE_AMOUNT; stage++) {
+        uint8_t address = getStageThresholdAddress(stage);
+        stageOffThresholds[stage] = readEeprom(address);
+        stageOnThresholds[stage] = readEeprom(address + 1);
+        if (stageOffThresholds[stage] == 0xFF || stageOnThresholds[stage] == 0xFF) {
+            stageOffThresholds[stage] = pgm_read_byte(defaultStageThresholds + stage * 2);
+            stageOnThresholds[stage] = pgm_read_byte(defaultStageThresholds + stage * 2 + 1);
+        }
     }
     spikeWidth = readEeprom(ADDRESS_SPIKE_WIDTH);
     if (spikeWidth == 0xFF) {
@@ -832,6 +1919,47 @@ void initializeTunables() {
     if (spikeResetTime == 0xFF) {
         spikeResetTime = 5;
     }
+    prestartLead = readEeprom(ADDRESS_PRESTART_LEAD);
+    if (prestartLead == 0xFF) {
+        prestartLead = 3;
+    }
+    satelliteAmount = readEeprom(ADDRESS_SATELLITE_AMOUNT);
+    if (satelliteAmount == 0xFF || satelliteAmount == 0) {
+        satelliteAmount = 1;
+    } else if (satelliteAmount > MAX_SATELLITE_AMOUNT) {
+        // Saved by firmware which supports more satellites.
+        satelliteAmount = MAX_SATELLITE_AMOUNT;
+    }
+    aggregateMode = readEeprom(ADDRESS_AGGREGATE);
+    if (aggregateMode == 0xFF) {
+        aggregateMode = AGGREGATE_HOTTEST;
+    }
+    temperatureOffset = readEeprom(ADDRESS_TEMPERATURE_OFFSET);
+    if (temperatureOffset == 0xFF) {
+        temperatureOffset = CALIBRATION_OFFSET_ZERO;
+    }
+    temperatureGain = readEeprom(ADDRESS_TEMPERATURE_GAIN);
+    if (temperatureGain == 0xFF) {
+        temperatureGain = DEFAULT_TEMPERATURE_GAIN;
+    }
+    updateTemperatureGainScale();
+}
+
+void initializeFanRuntime() {
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        uint16_t hours = readEepromWord(ADDRESS_FAN_HOURS + index * 2);
+        fanHours[index] = (hours == 0xFFFF) ? 0 : hours;
+    }
+}
+
+void initializeFanHealth() {
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        tachometerCounts[index] = 0;
+        stuckCounts[index] = 0;
+        fanRunTimes[index] = 0;
+        fanSpeeds[index] = 0;
+        fanBaselines[index] = readEeprom(ADDRESS_FAN_BASELINES + index);
+    }
 }
 
 void handleButton() {
@@ -840,6 +1968,9 @@ void handleButton() {
     }
     uint8_t button = lastPressedButton;
     lastPressedButton = BUTTON_NONE;
+    if (!lcdIsReady) {
+        return;
+    }
     timeoutDelay = 0;
     if (isEditingTunable) {
         if (button == BUTTON_ENTER) {
@@ -879,26 +2010,131 @@ void handleButton() {
     }
 }
 
+uint16_t getWarmStateCrc() {
+    uint16_t output = 0xFFFF;
+    const uint8_t *data = (const uint8_t *)&warmState;
+    for (uint8_t index = 0; index < sizeof(warmState_t) - sizeof(uint16_t); index++) {
+        output = _crc16_update(output, data[index]);
+    }
+    return output;
+}
+
+void saveWarmState() {
+    // Main loop may run much faster than the timer at high link rates.
+    if (!warmStateDelay) {
+        return;
+    }
+    warmStateDelay = 0;
+    warmState.magic = WARM_STATE_MAGIC;
+    warmState.runState = runState;
+    warmState.activeStages = activeStages;
+    warmState.runningFanAmount = runningFanAmount;
+    warmState.enabledFans = enabledFans;
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        warmState.fanMinutes[index] = fanMinutes[index];
+    }
+    warmState.currentTemperature = currentTemperature;
+    for (uint8_t index = 0; index < MAX_SATELLITE_AMOUNT; index++) {
+        warmState.satelliteTemperatures[index] = satelliteTemperatures[index];
+    }
+    for (uint8_t index = 0; index < MAX_HISTORY_LENGTH; index++) {
+        warmState.temperatureHistory[index] = temperatureHistory[index];
+    }
+    warmState.historyLength = historyLength;
+    warmState.spikeCooldown = spikeCooldown;
+    warmState.uptimeMinutes = uptimeMinutes;
+    warmState.lastRiseMinute = lastRiseMinute;
+    for (uint8_t index = 0; index < RISE_HISTORY_LENGTH; index++) {
+        warmState.riseMinutes[index] = riseMinutes[index];
+    }
+    warmState.riseAmount = riseAmount;
+    warmState.predictionMisses = predictionMisses;
+    warmState.predictedMinute = predictedMinute;
+    warmState.crc = getWarmStateCrc();
+}
+
+// Resumes control state after brown-out, watchdog, or external reset.
+void restoreWarmState() {
+    if ((resetFlags & (1 << PORF)) || warmState.magic != WARM_STATE_MAGIC
+            || warmState.crc != getWarmStateCrc()) {
+        return;
+    }
+    runState = warmState.runState;
+    activeStages = warmState.activeStages;
+    runningFanAmount = warmState.runningFanAmount;
+    enabledFans = warmState.enabledFans;
+    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
+        fanMinutes[index] = warmState.fanMinutes[index];
+    }
+    currentTemperature = warmState.currentTemperature;
+    for (uint8_t index = 0; index < MAX_SATELLITE_AMOUNT; index++) {
+        satelliteTemperatures[index] = warmState.satelliteTemperatures[index];
+    }
+    for (uint8_t index = 0; index < MAX_HISTORY_LENGTH; index++) {
+        temperatureHistory[index] = warmState.temperatureHistory[index];
+    }
+    historyLength = warmState.historyLength;
+    spikeCooldown = warmState.spikeCooldown;
+    uptimeMinutes = warmState.uptimeMinutes;
+    lastRiseMinute = warmState.lastRiseMinute;
+    for (uint8_t index = 0; index < RISE_HISTORY_LENGTH; index++) {
+        riseMinutes[index] = warmState.riseMinutes[index];
+    }
+    riseAmount = warmState.riseAmount;
+    predictionMisses = warmState.predictionMisses;
+    updatePrediction();
+    if (hasPrediction) {
+        predictedMinute = warmState.predictedMinute;
+    }
+    controlFans(enabledFans);
+}
+
+// Reads every satellite and starts the proper fan state right away,
+// instead of waiting for the main loop.
+void initializeRunState() {
+    for (uint8_t satellite = 0; satellite < satelliteAmount; satellite++) {
+        updateTemperature();
+    }
+    // A radiator which is already hot is not a rise event.
+    if (runState == RUN_STATE_OFF && !hasTemperatureFault
+            && currentTemperature >= stageOnThresholds[0]) {
+        runState = RUN_STATE_ON;
+    }
+    updateFans();
+}
+
 int main(void) {
     
     initializePinModes();
-    initializeLcd();
-    initializeTimer();
+    restoreWarmState();
     initializeTunables();
-    for (uint8_t index = 0; index < FAN_AMOUNT; index++) {
-        stuckCounts[index] = 0;
-    }
-    showScreen(SCREEN_MAIN);
+    initializeTachometers();
+    initializeTimer();
+    initializeFanRuntime();
+    initializeFanHealth();
+    initializeRunState();
+    // Slower startup tasks happen after the fans are under control.
+    calibrateLink();
+    // Recover from a hung main loop within 2 seconds.
+    wdt_enable(WDTO_2S);
     
     while (true) {
+        wdt_reset();
         updateTemperature();
         updateSpike();
+        updateRiseEvents();
+        updateHistory();
+        updateUptime();
+        updateLinkRate();
         updateFans();
+        updateFanRuntime();
         updateTachometers();
         updateFault();
         checkTimeout();
+        updateLcdStartup();
         updateScreen();
         handleButton();
+        saveWarmState();
     }
     
     return 0;
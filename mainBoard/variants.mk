@@ -0,0 +1,12 @@
+# Each variant selects a microcontroller and compile-time board options.
+# The simulator also includes this file, in order to build the same variants.
+VARIANT ?= fan6
+VARIANTS := fan6 fan4 fan2 fan2-atmega168
+fan6_MCU := atmega328p
+fan6_OPTIONS := -DFAN_AMOUNT=6
+fan4_MCU := atmega328p
+fan4_OPTIONS := -DFAN_AMOUNT=4
+fan2_MCU := atmega328p
+fan2_OPTIONS := -DFAN_AMOUNT=2
+fan2-atmega168_MCU := atmega168
+fan2-atmega168_OPTIONS := -DFAN_AMOUNT=2 -DMAX_SATELLITE_AMOUNT=2 -DMAX_SPIKE_WIDTH=5
@@ -1,12 +1,34 @@
 
 #include <stdint.h>
 #include <avr/io.h>
+#include <avr/eeprom.h>
 #include <util/delay.h>
 
 #define NULL ((void *)0)
 #define true 1
 #define false 0
 
+#define ADDRESS_SATELLITE 0
+
+// Set to false in order to send full messages all the time.
+#define EVENT_REPORTING true
+// Minimum change in ADC value which causes a full message.
+#define REPORT_DELTA 2
+// Number of samples after which a full message is sent regardless of changes.
+#define KEEPALIVE_SAMPLES 64
+// Added to the address count when the main board requests a full message.
+#define FULL_REQUEST_OFFSET 8
+#define FULL_MESSAGE_LENGTH 20
+
+// Timer ticks every 256 clock cycles, and overflows every 256 ticks.
+// At 9.6 MHz, the timer overflows about every 6.8 ms.
+#define TIMER_TICKS_PER_MS (F_CPU / 256000.0)
+// SCK is held for 2 ms or longer while selecting a satellite. This is
+// twice the slowest link half-period, and half of the main board break.
+#define LONG_PULSE_TICKS ((uint8_t)(TIMER_TICKS_PER_MS * 2))
+// Temperature is sampled after this many timer overflows.
+#define SAMPLE_OVERFLOWS 5
+
 #define sleepMicroseconds(microseconds) _delay_us(microseconds)
 
 #define tempPinInput() DDRB &= ~(1 << DDB3)
@@ -15,26 +37,69 @@
 #define sckPinRead() (PINB & (1 << PINB4))
 
 #define dataPinOutput() DDRB |= (1 << DDB1)
+#define dataPinInput() DDRB &= ~(1 << DDB1)
 #define dataPinHigh() PORTB |= (1 << PORTB1)
 #define dataPinLow() PORTB &= ~(1 << PORTB1)
 
+uint8_t satelliteAddress;
+uint8_t isSelected = false;
+uint8_t isAddressing = false;
+uint8_t addressEdgeCount = 0;
 uint8_t currentData = 0;
 uint8_t runDelay = 0;
 uint8_t messageIndex = 0;
+uint8_t messageLength = FULL_MESSAGE_LENGTH;
+uint8_t shouldSendFull = true;
+uint8_t keepaliveDelay = 0;
+// Most recent temperature and rate in a full message.
 uint16_t messageTemperature = 0;
+int8_t messageRate = 0;
+
+uint8_t lastSck;
+uint8_t lastEdgeTime;
+uint8_t hasLongPulse = false;
+uint8_t sampleDelay = 0;
+uint8_t sampleCount = 0;
+// ADC value multiplied by 16.
+uint16_t filteredTemperature = 0;
+uint16_t rateReference = 0;
+// Change in quarter ADC values during the last 256 samples.
+int8_t currentRate = 0;
 
 void initializePinModes() {
     tempPinInput();
     sckPinInput();
-    dataPinOutput();
+    // Data pin stays released until the main board selects this satellite.
+    dataPinLow();
+    dataPinInput();
 }
 
-uint16_t readTemperature() {
+// Called about every 34 ms.
+void sampleTemperature() {
+    // Read the conversion started during the previous sample.
+    uint16_t temperatureV = ADC;
     ADCSRA |= (1 << ADSC);
-    while (ADCSRA & (1 << ADSC)) {
-        // Wait in a loop.
+    if (filteredTemperature == 0) {
+        filteredTemperature = temperatureV << 4;
+        rateReference = filteredTemperature;
+    } else {
+        // Exponential moving average with weight 1/16.
+        filteredTemperature += temperatureV - (filteredTemperature >> 4);
+    }
+    sampleCount += 1;
+    if (sampleCount == 0) {
+        int16_t rate = (int16_t)(filteredTemperature - rateReference) >> 2;
+        if (rate > 127) {
+            rate = 127;
+        } else if (rate < -128) {
+            rate = -128;
+        }
+        currentRate = rate;
+        rateReference = filteredTemperature;
+    }
+    if (keepaliveDelay < KEEPALIVE_SAMPLES) {
+        keepaliveDelay += 1;
     }
-    return ADC;
 }
 
 void invertData() {
@@ -50,11 +115,37 @@ void invertData() {
 // Our little rinky-dink serial protocol:
 // > The main board will read satellite data on rising edge of SCK
 // > Satellite sends temperature "messages" repeatedly
-// > Each message consists of 11 "runs" of different lengths
+// > Each message consists of "runs" of different lengths
 // > Satellite data is inverted between each run
 // > First run of each message is 3 cycles long
-// > The remaining 10 runs encode the temperature as a 10-bit integer
 // > A 2-cycle run represents bit 1, and a 1-cycle run represents bit 0
+// > Second run is 0 when nothing has changed, in which case the message ends
+// > Otherwise, the next 10 runs encode the filtered temperature as a 10-bit integer
+// > The last 8 runs encode the rate of change as a signed 8-bit integer
+// Multiple satellites may share SCK and data lines:
+// > The main board holds SCK low for a long time to start addressing
+// > All satellites release the data line
+// > The main board then pulses SCK once more than the satellite address
+// > The main board holds SCK high for a long time to end addressing
+// > The addressed satellite drives the data line and sends messages
+
+// Returns whether to send a full message.
+uint8_t startMessage() {
+    uint16_t temperature = filteredTemperature >> 4;
+    uint16_t difference = (temperature > messageTemperature)
+        ? temperature - messageTemperature : messageTemperature - temperature;
+    if (EVENT_REPORTING && !shouldSendFull && keepaliveDelay < KEEPALIVE_SAMPLES
+            && difference < REPORT_DELTA && currentRate == messageRate) {
+        messageLength = 2;
+        return false;
+    }
+    messageTemperature = temperature;
+    messageRate = currentRate;
+    messageLength = FULL_MESSAGE_LENGTH;
+    shouldSendFull = false;
+    keepaliveDelay = 0;
+    return true;
+}
 
 void handleSckEdge() {
     if (runDelay > 0) {
@@ -64,34 +155,104 @@ void handleSckEdge() {
     invertData();
     if (messageIndex == 0) {
         runDelay = 2;
+    } else if (messageIndex == 1) {
+        runDelay = startMessage();
+    } else if (messageIndex < 12) {
+        runDelay = (messageTemperature >> (messageIndex - 2)) & 1;
     } else {
-        if (messageIndex == 1) {
-            messageTemperature = readTemperature();
-        }
-        uint16_t mask = ((uint16_t)1 << (messageIndex - 1));
-        runDelay = (messageTemperature & mask) ? 1 : 0;
+        runDelay = ((uint8_t)messageRate >> (messageIndex - 12)) & 1;
     }
     messageIndex += 1;
-    if (messageIndex > 10) {
+    if (messageIndex >= messageLength) {
         messageIndex = 0;
     }
 }
 
-int main(void) {
-    
+void handleLongPulse(uint8_t sck) {
+    if (!sck) {
+        isSelected = false;
+        dataPinInput();
+        isAddressing = true;
+        addressEdgeCount = 0;
+    } else if (isAddressing) {
+        isAddressing = false;
+        uint8_t selectCount = satelliteAddress + 1;
+        if (addressEdgeCount == selectCount + FULL_REQUEST_OFFSET) {
+            shouldSendFull = true;
+            addressEdgeCount = selectCount;
+        }
+        if (addressEdgeCount == selectCount) {
+            isSelected = true;
+            currentData = 0;
+            runDelay = 0;
+            messageIndex = 0;
+            dataPinLow();
+            dataPinOutput();
+        }
+    }
+}
+
+void handleSckFall() {
+    if (isAddressing) {
+        if (addressEdgeCount < 0xFF) {
+            addressEdgeCount += 1;
+        }
+    } else if (isSelected) {
+        handleSckEdge();
+    }
+}
+
+void initializeSatellite() {
     initializePinModes();
     
+    satelliteAddress = eeprom_read_byte((uint8_t *)ADDRESS_SATELLITE);
+    if (satelliteAddress == 0xFF) {
+        satelliteAddress = 0;
+    }
+    
+    // Run timer with clock divided by 256.
+    TCCR0B = (1 << CS02);
+    
     // Configure PB3 as analog input.
     ADMUX = (1 << MUX1) | (1 << MUX0);
     ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+    ADCSRA |= (1 << ADSC);
     
-    uint8_t lastSck = sckPinRead();
-    while (true) {
-        uint8_t currentSck = sckPinRead();
-        if (lastSck && !currentSck) {
-            handleSckEdge();
+    lastSck = sckPinRead();
+    lastEdgeTime = TCNT0;
+}
+
+// Called during each iteration of the main loop.
+void pollSatellite() {
+    uint8_t currentSck = sckPinRead();
+    if (currentSck != lastSck) {
+        if (!currentSck) {
+            handleSckFall();
         }
         lastSck = currentSck;
+        lastEdgeTime = TCNT0;
+        hasLongPulse = false;
+    } else if (!hasLongPulse && (uint8_t)(TCNT0 - lastEdgeTime) >= LONG_PULSE_TICKS) {
+        handleLongPulse(currentSck);
+        hasLongPulse = true;
+    }
+    // Timer overflows every 256 ticks.
+    if (TIFR0 & (1 << TOV0)) {
+        TIFR0 = (1 << TOV0);
+        sampleDelay += 1;
+        if (sampleDelay >= SAMPLE_OVERFLOWS) {
+            sampleTemperature();
+            sampleDelay = 0;
+        }
+    }
+}
+
+int main(void) {
+    
+    initializeSatellite();
+    
+    while (true) {
+        pollSatellite();
     }
     
     return 0;
@@ -0,0 +1,14 @@
+
+#ifndef SIMULATOR_AVR_EEPROM_H
+#define SIMULATOR_AVR_EEPROM_H
+
+#include <stdint.h>
+
+#define eeprom_busy_wait()
+
+uint8_t eeprom_read_byte(const uint8_t *address);
+void eeprom_write_byte(uint8_t *address, uint8_t value);
+uint16_t eeprom_read_word(const uint16_t *address);
+void eeprom_write_word(uint16_t *address, uint16_t value);
+
+#endif
@@ -0,0 +1,21 @@
+
+#ifndef SIMULATOR_AVR_INTERRUPT_H
+#define SIMULATOR_AVR_INTERRUPT_H
+
+#define ISR(vector) void vector(void)
+
+#define TIMER1_COMPA_vect simTimer1CompareAInterrupt
+#define PCINT0_vect simPinChange0Interrupt
+#define PCINT2_vect simPinChange2Interrupt
+
+void simTimer1CompareAInterrupt(void);
+void simPinChange0Interrupt(void);
+void simPinChange2Interrupt(void);
+
+void simEnableInterrupts(void);
+void simDisableInterrupts(void);
+
+#define sei() simEnableInterrupts()
+#define cli() simDisableInterrupts()
+
+#endif
@@ -0,0 +1,127 @@
+
+// Host replacement for <avr/io.h>. Registers are plain variables
+// which the simulated devices in src/ read and write.
+
+#ifndef SIMULATOR_AVR_IO_H
+#define SIMULATOR_AVR_IO_H
+
+#include <stdint.h>
+
+extern uint8_t DDRB, PORTB, PINB;
+extern uint8_t DDRC, PORTC, PINC;
+extern uint8_t DDRD, PORTD, PIND;
+extern uint8_t TCCR0B, TCNT0, TIFR0;
+extern uint8_t TCCR1B, TIMSK1;
+extern uint16_t OCR1A, TCNT1;
+extern uint8_t PCICR, PCMSK0, PCMSK2;
+extern uint8_t ADMUX, ADCSRA;
+extern uint16_t ADC;
+extern uint8_t MCUSR;
+
+#define DDB0 0
+#define DDB1 1
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define DDB6 6
+#define DDB7 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB4 4
+#define PORTB5 5
+#define PORTB6 6
+#define PORTB7 7
+#define PINB0 0
+#define PINB1 1
+#define PINB2 2
+#define PINB3 3
+#define PINB4 4
+#define PINB5 5
+#define PINB6 6
+#define PINB7 7
+
+#define DDC0 0
+#define DDC1 1
+#define DDC2 2
+#define DDC3 3
+#define DDC4 4
+#define DDC5 5
+#define DDC6 6
+#define PORTC0 0
+#define PORTC1 1
+#define PORTC2 2
+#define PORTC3 3
+#define PORTC4 4
+#define PORTC5 5
+#define PORTC6 6
+#define PINC0 0
+#define PINC1 1
+#define PINC2 2
+#define PINC3 3
+#define PINC4 4
+#define PINC5 5
+#define PINC6 6
+
+#define DDD0 0
+#define DDD1 1
+#define DDD2 2
+#define DDD3 3
+#define DDD4 4
+#define DDD5 5
+#define DDD6 6
+#define DDD7 7
+#define PORTD0 0
+#define PORTD1 1
+#define PORTD2 2
+#define PORTD3 3
+#define PORTD4 4
+#define PORTD5 5
+#define PORTD6 6
+#define PORTD7 7
+#define PIND0 0
+#define PIND1 1
+#define PIND2 2
+#define PIND3 3
+#define PIND4 4
+#define PIND5 5
+#define PIND6 6
+#define PIND7 7
+
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define TOV0 1
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define OCIE1A 1
+
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT16 0
+#define PCINT17 1
+#define PCINT18 2
+
+#define MUX0 0
+#define MUX1 1
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIF 4
+#define ADSC 6
+#define ADEN 7
+
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+
+#endif
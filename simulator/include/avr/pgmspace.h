@@ -0,0 +1,12 @@
+
+#ifndef SIMULATOR_AVR_PGMSPACE_H
+#define SIMULATOR_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+// Program memory is ordinary memory on the host.
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+#endif
@@ -0,0 +1,11 @@
+
+#ifndef SIMULATOR_AVR_WDT_H
+#define SIMULATOR_AVR_WDT_H
+
+// The simulator never hangs, so the watchdog does nothing.
+#define WDTO_2S 7
+#define wdt_enable(timeout)
+#define wdt_disable()
+#define wdt_reset()
+
+#endif
@@ -0,0 +1,11 @@
+
+// Adds avr-libc extensions to the host <stdlib.h>.
+
+#ifndef SIMULATOR_STDLIB_H
+#define SIMULATOR_STDLIB_H
+
+#include_next <stdlib.h>
+
+char *itoa(int value, char *text, int radix);
+
+#endif
@@ -0,0 +1,20 @@
+
+#ifndef SIMULATOR_UTIL_CRC16_H
+#define SIMULATOR_UTIL_CRC16_H
+
+#include <stdint.h>
+
+// Same polynomial as avr-libc (0xA001).
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t data) {
+    crc ^= data;
+    for (uint8_t count = 0; count < 8; count++) {
+        if (crc & 1) {
+            crc = (crc >> 1) ^ 0xA001;
+        } else {
+            crc = (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+#endif
@@ -0,0 +1,13 @@
+
+#ifndef SIMULATOR_UTIL_DELAY_H
+#define SIMULATOR_UTIL_DELAY_H
+
+#include <stdint.h>
+
+// Delays advance simulated time, during which devices and interrupts run.
+void simDelay(uint64_t nanoseconds);
+
+#define _delay_us(microseconds) simDelay((uint64_t)((microseconds) * 1000.0))
+#define _delay_ms(milliseconds) simDelay((uint64_t)((milliseconds) * 1000000.0))
+
+#endif
@@ -0,0 +1,190 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <util/delay.h>
+#include "avrModel.h"
+
+#define MAX_DEVICE_AMOUNT 8
+// Devices observe pins at least this often during long delays.
+#define MAX_STEP_DURATION SIM_MILLISECOND
+#define TIMER1_PRESCALER 1024
+
+uint8_t DDRB, PORTB, PINB;
+uint8_t DDRC, PORTC, PINC;
+uint8_t DDRD, PORTD, PIND;
+uint8_t TCCR0B, TCNT0, TIFR0;
+uint8_t TCCR1B, TIMSK1;
+uint16_t OCR1A, TCNT1;
+uint8_t PCICR, PCMSK0, PCMSK2;
+uint8_t ADMUX, ADCSRA;
+uint16_t ADC;
+uint8_t MCUSR;
+
+uint64_t simTime = 0;
+uint8_t simEeprom[SIM_EEPROM_SIZE];
+
+simDevice_t devices[MAX_DEVICE_AMOUNT];
+uint8_t deviceAmount = 0;
+uint8_t interruptsAreEnabled = false;
+uint8_t isInInterrupt = false;
+uint64_t nextTimerTime = 0;
+uint8_t timerIsPending = false;
+uint8_t lastPinB = 0;
+uint8_t lastPinD = 0;
+uint8_t pinChange0IsPending = false;
+uint8_t pinChange2IsPending = false;
+
+void simAddDevice(simDevice_t device) {
+    if (deviceAmount >= MAX_DEVICE_AMOUNT) {
+        fprintf(stderr, "Too many simulated devices.\n");
+        exit(1);
+    }
+    devices[deviceAmount] = device;
+    deviceAmount += 1;
+}
+
+void simResetRegisters(void) {
+    DDRB = PORTB = PINB = 0;
+    DDRC = PORTC = PINC = 0;
+    DDRD = PORTD = PIND = 0;
+    TCCR0B = TCNT0 = TIFR0 = 0;
+    TCCR1B = TIMSK1 = 0;
+    OCR1A = TCNT1 = 0;
+    PCICR = PCMSK0 = PCMSK2 = 0;
+    ADMUX = ADCSRA = 0;
+    ADC = 0;
+    MCUSR = (1 << PORF);
+    memset(simEeprom, 0xFF, sizeof(simEeprom));
+    simTime = 0;
+    nextTimerTime = 0;
+    lastPinB = lastPinD = 0;
+}
+
+void simSetPin(uint8_t *pinRegister, uint8_t bit, uint8_t value) {
+    if (value) {
+        *pinRegister |= (1 << bit);
+    } else {
+        *pinRegister &= ~(1 << bit);
+    }
+}
+
+uint64_t getTimerPeriod(void) {
+    return (uint64_t)(OCR1A + 1) * TIMER1_PRESCALER * SIM_SECOND / F_CPU;
+}
+
+void detectPinChanges(void) {
+    if ((PINB ^ lastPinB) & PCMSK0 && (PCICR & (1 << PCIE0))) {
+        pinChange0IsPending = true;
+    }
+    if ((PIND ^ lastPinD) & PCMSK2 && (PCICR & (1 << PCIE2))) {
+        pinChange2IsPending = true;
+    }
+    lastPinB = PINB;
+    lastPinD = PIND;
+}
+
+// Boards with fewer than 4 fans have no tachometers on port B,
+// and do not handle this interrupt.
+__attribute__((weak)) void simPinChange0Interrupt(void) {
+}
+
+void serviceInterrupts(void) {
+    if (!interruptsAreEnabled || isInInterrupt) {
+        return;
+    }
+    // Interrupts are disabled while running an interrupt handler.
+    isInInterrupt = true;
+    interruptsAreEnabled = false;
+    if (timerIsPending) {
+        timerIsPending = false;
+        simTimer1CompareAInterrupt();
+    }
+    if (pinChange0IsPending) {
+        pinChange0IsPending = false;
+        simPinChange0Interrupt();
+    }
+    if (pinChange2IsPending) {
+        pinChange2IsPending = false;
+        simPinChange2Interrupt();
+    }
+    interruptsAreEnabled = true;
+    isInInterrupt = false;
+}
+
+void runDevices(void) {
+    for (uint8_t index = 0; index < deviceAmount; index++) {
+        devices[index]();
+    }
+    detectPinChanges();
+}
+
+void simDelay(uint64_t nanoseconds) {
+    uint64_t endTime = simTime + nanoseconds;
+    uint8_t timerIsEnabled = (TIMSK1 & (1 << OCIE1A)) && TCCR1B != 0;
+    if (timerIsEnabled && nextTimerTime <= simTime) {
+        nextTimerTime = simTime + getTimerPeriod();
+    }
+    while (true) {
+        runDevices();
+        serviceInterrupts();
+        if (simTime >= endTime) {
+            break;
+        }
+        uint64_t stepTime = simTime + MAX_STEP_DURATION;
+        if (stepTime > endTime) {
+            stepTime = endTime;
+        }
+        if (timerIsEnabled && stepTime >= nextTimerTime) {
+            stepTime = nextTimerTime;
+            timerIsPending = true;
+            nextTimerTime += getTimerPeriod();
+        }
+        simTime = stepTime;
+    }
+}
+
+void simEnableInterrupts(void) {
+    if (isInInterrupt) {
+        return;
+    }
+    interruptsAreEnabled = true;
+    serviceInterrupts();
+}
+
+void simDisableInterrupts(void) {
+    if (isInInterrupt) {
+        return;
+    }
+    interruptsAreEnabled = false;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *address) {
+    return simEeprom[(uintptr_t)address % SIM_EEPROM_SIZE];
+}
+
+void eeprom_write_byte(uint8_t *address, uint8_t value) {
+    simEeprom[(uintptr_t)address % SIM_EEPROM_SIZE] = value;
+}
+
+uint16_t eeprom_read_word(const uint16_t *address) {
+    uintptr_t index = (uintptr_t)address;
+    return eeprom_read_byte((const uint8_t *)index)
+        | ((uint16_t)eeprom_read_byte((const uint8_t *)(index + 1)) << 8);
+}
+
+void eeprom_write_word(uint16_t *address, uint16_t value) {
+    uintptr_t index = (uintptr_t)address;
+    eeprom_write_byte((uint8_t *)index, value & 0xFF);
+    eeprom_write_byte((uint8_t *)(index + 1), value >> 8);
+}
+
+char *itoa(int value, char *text, int radix) {
+    // The firmware only uses base 10.
+    (void)radix;
+    sprintf(text, "%d", value);
+    return text;
+}
@@ -0,0 +1,29 @@
+
+// Simulated time, registers, interrupts, and EEPROM of the main microcontroller.
+
+#ifndef AVR_MODEL_H
+#define AVR_MODEL_H
+
+#include <stdint.h>
+
+#define true 1
+#define false 0
+
+#define SIM_EEPROM_SIZE 1024
+#define SIM_MICROSECOND 1000ULL
+#define SIM_MILLISECOND (1000 * SIM_MICROSECOND)
+#define SIM_SECOND (1000 * SIM_MILLISECOND)
+
+// Devices run between every step of simulated time. A device reads
+// output registers, and updates input registers.
+typedef void (*simDevice_t)(void);
+
+// Nanoseconds since reset.
+extern uint64_t simTime;
+extern uint8_t simEeprom[SIM_EEPROM_SIZE];
+
+void simAddDevice(simDevice_t device);
+void simResetRegisters(void);
+void simSetPin(uint8_t *pinRegister, uint8_t bit, uint8_t value);
+
+#endif
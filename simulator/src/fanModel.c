@@ -0,0 +1,81 @@
+
+#include <avr/io.h>
+#include "avrModel.h"
+#include "fanModel.h"
+
+#define SPIN_UP_DURATION (800 * SIM_MILLISECOND)
+// 1500 RPM with two tachometer pulses per revolution.
+#define TACHOMETER_EDGE_DURATION (10 * SIM_MILLISECOND)
+// Tachometer levels are updated at this resolution unless fan controls change.
+#define UPDATE_PERIOD SIM_MILLISECOND
+
+typedef struct {
+    uint8_t controlBit;
+    uint8_t *tachometerRegister;
+    uint8_t tachometerBit;
+    uint8_t isRunning;
+    uint8_t isBroken;
+    uint64_t startTime;
+} fan_t;
+
+fan_t fans[SIM_FAN_AMOUNT] = {
+    {PORTC5, &PIND, PIND1},
+    {PORTC4, &PIND, PIND0},
+    {PORTC3, &PIND, PIND2},
+    {PORTC0, &PINB, PINB2},
+    {PORTC1, &PINB, PINB1},
+    {PORTC2, &PINB, PINB0}
+};
+
+uint8_t lastControls = 0;
+uint64_t nextUpdateTime = 0;
+
+void runFans(void) {
+    uint8_t controls = DDRC & PORTC;
+    if (controls == lastControls && simTime < nextUpdateTime) {
+        return;
+    }
+    lastControls = controls;
+    nextUpdateTime = simTime + UPDATE_PERIOD;
+    for (uint8_t index = 0; index < SIM_FAN_AMOUNT; index++) {
+        fan_t *fan = fans + index;
+        uint8_t mask = (1 << fan->controlBit);
+        uint8_t isEnabled = ((controls & mask) > 0);
+        if (isEnabled && !fan->isRunning) {
+            fan->startTime = simTime;
+        }
+        fan->isRunning = isEnabled;
+        // Tachometer is pulled up while the fan is stopped.
+        uint8_t level = 1;
+        if (fan->isRunning && !fan->isBroken) {
+            uint64_t duration = simTime - fan->startTime;
+            // Tachometer speeds up while the fan spins up.
+            if (duration >= SPIN_UP_DURATION) {
+                level = ((duration - SPIN_UP_DURATION) / TACHOMETER_EDGE_DURATION) & 1;
+            } else {
+                level = ((duration / (4 * TACHOMETER_EDGE_DURATION)) & 1);
+            }
+        }
+        simSetPin(fan->tachometerRegister, fan->tachometerBit, level);
+    }
+}
+
+void initializeFanModel(void) {
+    simAddDevice(&runFans);
+}
+
+void breakFan(uint8_t fan) {
+    if (fan < SIM_FAN_AMOUNT) {
+        fans[fan].isBroken = true;
+    }
+}
+
+uint8_t getRunningFanAmount(void) {
+    uint8_t output = 0;
+    for (uint8_t index = 0; index < SIM_FAN_AMOUNT; index++) {
+        if (fans[index].isRunning) {
+            output += 1;
+        }
+    }
+    return output;
+}
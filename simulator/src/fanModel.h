@@ -0,0 +1,16 @@
+
+// Fans attached to the control and tachometer pins of the main microcontroller.
+
+#ifndef FAN_MODEL_H
+#define FAN_MODEL_H
+
+#include <stdint.h>
+
+#define SIM_FAN_AMOUNT 6
+
+void initializeFanModel(void);
+// A broken fan never spins, so its tachometer stays flat.
+void breakFan(uint8_t fan);
+uint8_t getRunningFanAmount(void);
+
+#endif
@@ -0,0 +1,294 @@
+
+// Drives the display code of the main board firmware against a model
+// of the display controller. Checks screen contents, and reports the
+// render cost of each screen and state transition.
+
+#include <stdio.h>
+#include <string.h>
+#include "avrModel.h"
+#include "lcdModel.h"
+
+#define main firmwareMain
+#include "../../mainBoard/src/main.c"
+#undef main
+
+#define DEGREE "\xF2"
+
+uint64_t measurementStartTime;
+uint32_t failureAmount = 0;
+
+void startMeasurement(void) {
+    resetLcdStats();
+    measurementStartTime = simTime;
+}
+
+void printRow(const uint8_t *text) {
+    for (uint8_t index = 0; index < SIM_LCD_WIDTH; index++) {
+        uint8_t character = text[index];
+        if (character == 0xF2) {
+            printf("°");
+        } else if (character == 0xFF) {
+            printf("‾");
+        } else if (character == 0x7E) {
+            printf("→");
+        } else if (character >= 0x20 && character < 0x7F) {
+            putchar(character);
+        } else {
+            printf("\\x%02X", character);
+        }
+    }
+}
+
+void expectRow(const char *name, uint8_t row, const char *expectedText) {
+    uint8_t text[SIM_LCD_WIDTH + 1];
+    getLcdRow(row, text);
+    if (memcmp(text, expectedText, SIM_LCD_WIDTH) == 0) {
+        return;
+    }
+    failureAmount += 1;
+    printf("FAIL %s, row %u\n  expected: \"", name, row);
+    printRow((const uint8_t *)expectedText);
+    printf("\"\n  actual:   \"");
+    printRow(text);
+    printf("\"\n");
+}
+
+void expectScreen(const char *name, const char *expectedRow0, const char *expectedRow1) {
+    expectRow(name, 0, expectedRow0);
+    expectRow(name, 1, expectedRow1);
+}
+
+// Prints the cost of rendering since `startMeasurement`.
+void finishMeasurement(const char *name) {
+    double busyTime = (double)lcdStats.busyTime / SIM_MILLISECOND;
+    double elapsedTime = (double)(simTime - measurementStartTime) / SIM_MILLISECOND;
+    printf("%-22s %5u %5u %5u %5u %9.2f %9.2f\n", name, lcdStats.commandAmount,
+        lcdStats.characterAmount, lcdStats.glyphByteAmount, lcdStats.cursorMoveAmount,
+        busyTime, elapsedTime);
+    if (lcdStats.busyViolationAmount > 0) {
+        failureAmount += 1;
+        printf("FAIL %s, %u bytes sent while the controller was busy\n",
+            name, lcdStats.busyViolationAmount);
+    }
+}
+
+void measureUpdate(const char *name) {
+    startMeasurement();
+    updateScreen();
+    finishMeasurement(name);
+}
+
+void measureShow(const char *name, uint8_t screen) {
+    startMeasurement();
+    showScreen(screen);
+    finishMeasurement(name);
+}
+
+void measureButton(const char *name, uint8_t button) {
+    startMeasurement();
+    lastPressedButton = button;
+    handleButton();
+    finishMeasurement(name);
+}
+
+void runStartup(void) {
+    startMeasurement();
+    while (!lcdIsReady) {
+        updateLcdStartup();
+        sleepMilliseconds(1);
+    }
+    finishMeasurement("Startup");
+    if (!lcdIsOn()) {
+        failureAmount += 1;
+        printf("FAIL Startup, display is off\n");
+    }
+    expectScreen("Startup", "?" DEGREE "C     Idle    ", "_ Healthy       ");
+    // Timer ticks would otherwise toggle the heartbeat between checks.
+    TIMSK1 = 0;
+}
+
+void runMainScreen(void) {
+    measureUpdate("Unchanged");
+    if (lcdStats.commandAmount + lcdStats.characterAmount > 0) {
+        failureAmount += 1;
+        printf("FAIL Unchanged, screen was redrawn\n");
+    }
+    currentTemperature = 31;
+    measureUpdate("Temperature");
+    expectScreen("Temperature", "31" DEGREE "C    Idle    ", "_ Healthy       ");
+    currentTemperature = 8;
+    measureUpdate("Temperature shorter");
+    expectScreen("Temperature shorter", "8" DEGREE "C     Idle    ", "_ Healthy       ");
+    runState = RUN_STATE_ON;
+    activeStages = 0x01;
+    measureUpdate("Run state");
+    expectScreen("Run state", "8" DEGREE "C     Stage 1 ", "_ Healthy       ");
+    activeStages = 0x03;
+    measureUpdate("Stage");
+    expectScreen("Stage", "8" DEGREE "C     Stage 2 ", "_ Healthy       ");
+    activeStages = 0x01;
+    measureUpdate("Stage lower");
+    expectScreen("Stage lower", "8" DEGREE "C     Stage 1 ", "_ Healthy       ");
+    heartbeat = 1;
+    measureUpdate("Heartbeat");
+    expectScreen("Heartbeat", "8" DEGREE "C     Stage 1 ", "\xFF Healthy       ");
+    currentFault = FAULT_FAN;
+    // Every board variant has at least 2 fans.
+    currentFaultMask = 0x02;
+    measureUpdate("Fan fault");
+    expectScreen("Fan fault", "8" DEGREE "C     Stage 1 ", "\xFF Fan 2 fault!  ");
+    currentFaultMask = 0x03;
+    measureUpdate("Fans fault");
+    expectScreen("Fans fault", "8" DEGREE "C     Stage 1 ", "\xFF Fans 12!      ");
+    currentFault = FAULT_NONE;
+    currentFaultMask = 0;
+    measureUpdate("Fault cleared");
+    expectScreen("Fault cleared", "8" DEGREE "C     Stage 1 ", "\xFF Healthy       ");
+    measureShow("Main screen", SCREEN_MAIN);
+    expectScreen("Main screen", "8" DEGREE "C     Stage 1 ", "\xFF Healthy       ");
+}
+
+void expectGlyphRow(const char *name, uint8_t glyph, uint8_t row, uint8_t expectedRow) {
+    uint8_t actualRow = lcdCgram[glyph * GLYPH_HEIGHT + row];
+    if (actualRow == expectedRow) {
+        return;
+    }
+    failureAmount += 1;
+    printf("FAIL %s, glyph %u row %u: expected 0x%02X, actual 0x%02X\n",
+        name, glyph, row, expectedRow, actualRow);
+}
+
+void expectGlyphByteAmount(const char *name, uint32_t expectedAmount) {
+    if (lcdStats.glyphByteAmount == expectedAmount) {
+        return;
+    }
+    failureAmount += 1;
+    printf("FAIL %s, expected %u glyph bytes, actual %u\n",
+        name, expectedAmount, lcdStats.glyphByteAmount);
+}
+
+void runHistoryScreen(void) {
+    const char graphRow[] = {0, 1, 2, 3, 4, 5, 6, 7, ' '};
+    char expectedRow0[SIM_LCD_WIDTH + 1];
+    char expectedRow1[SIM_LCD_WIDTH + 1];
+    measureButton("Screen history", BUTTON_NEXT);
+    memcpy(expectedRow0, graphRow, sizeof(graphRow));
+    snprintf(expectedRow0 + sizeof(graphRow), 8, "%-7s", "?" DEGREE "C");
+    snprintf(expectedRow1, sizeof(expectedRow1), "Last 40m %-7s", "?" DEGREE "C");
+    expectScreen("Screen history", expectedRow0, expectedRow1);
+    expectGlyphByteAmount("Screen history", GLYPH_AMOUNT * GLYPH_HEIGHT);
+    measureUpdate("History unchanged");
+    expectGlyphByteAmount("History unchanged", 0);
+    // Ten minutes of rising temperature, with fans during the last five minutes.
+    for (uint8_t minute = 0; minute < 10; minute++) {
+        currentTemperature = 30 + minute;
+        runningFanAmount = (minute >= 5) ? FAN_AMOUNT : 0;
+        historyDelay = 60;
+        updateHistory();
+    }
+    measureUpdate("History samples");
+    snprintf(expectedRow0 + sizeof(graphRow), 8, "%-7s", "39" DEGREE "C");
+    snprintf(expectedRow1, sizeof(expectedRow1), "Last 40m %-7s", "30" DEGREE "C");
+    expectScreen("History samples", expectedRow0, expectedRow1);
+    // Only the two rightmost glyphs contain samples.
+    expectGlyphByteAmount("History samples", 2 * GLYPH_HEIGHT);
+    // Samples 35 to 39 degrees C have bar heights of 4 to 7 pixels.
+    expectGlyphRow("History samples", 7, 0, 0x01);
+    expectGlyphRow("History samples", 7, 2, 0x0F);
+    expectGlyphRow("History samples", 7, 6, 0x1F);
+    expectGlyphRow("History samples", 7, 7, 0x1F);
+    // Samples 30 to 34 degrees C have bar heights of 1 to 3 pixels, without fans.
+    expectGlyphRow("History samples", 6, 4, 0x03);
+    expectGlyphRow("History samples", 6, 6, 0x1F);
+    expectGlyphRow("History samples", 6, 7, 0x00);
+    expectGlyphRow("History samples", 5, 6, 0x00);
+    currentTemperature = 8;
+    runningFanAmount = 0;
+}
+
+void runTunableScreens(void) {
+    for (uint8_t screen = FIRST_TUNABLE_SCREEN; screen < SCREEN_AMOUNT; screen++) {
+        tunableScreen_t *tunable = tunableScreens + screen - FIRST_TUNABLE_SCREEN;
+        char name[40];
+        snprintf(name, sizeof(name), "Screen %s", (const char *)tunable->title);
+        measureButton(name, BUTTON_NEXT);
+        char expectedText[SIM_LCD_WIDTH + 1];
+        snprintf(expectedText, sizeof(expectedText), "%-16s", (const char *)tunable->title);
+        expectRow(name, 0, expectedText);
+    }
+    measureButton("Screen main", BUTTON_NEXT);
+    expectScreen("Screen main", "8" DEGREE "C     Stage 1 ", "\xFF Healthy       ");
+}
+
+void runTunableEdit(void) {
+    measureButton("Screen history", BUTTON_NEXT);
+    measureButton("Screen stage 1 off", BUTTON_NEXT);
+    expectScreen("Screen stage 1 off", "Stage 1 off:    ", "  29" DEGREE "C          ");
+    measureButton("Edit start", BUTTON_ENTER);
+    expectScreen("Edit start", "Stage 1 off:    ", "\x7E 29" DEGREE "C          ");
+    measureButton("Edit increase", BUTTON_NEXT);
+    expectScreen("Edit increase", "Stage 1 off:    ", "\x7E 30" DEGREE "C          ");
+    measureButton("Edit save", BUTTON_ENTER);
+    expectScreen("Edit save", "Stage 1 off:    ", "  30" DEGREE "C          ");
+}
+
+void runCalibrationEdit(void) {
+    measureButton("Screen history", BUTTON_PREV);
+    measureButton("Screen main", BUTTON_PREV);
+    measureButton("Screen replace fan", BUTTON_PREV);
+    expectScreen("Screen replace fan", "Replace fan:    ", "  None          ");
+    measureButton("Screen temp gain", BUTTON_PREV);
+    expectScreen("Screen temp gain", "Temp gain:      ", "  100%          ");
+    measureButton("Screen temp offset", BUTTON_PREV);
+    expectScreen("Screen temp offset", "Temp offset:    ", "  +0" DEGREE "C          ");
+    measureButton("Offset start", BUTTON_ENTER);
+    measureButton("Offset decrease", BUTTON_PREV);
+    expectScreen("Offset decrease", "Temp offset:    ", "\x7E -1" DEGREE "C          ");
+    measureButton("Offset save", BUTTON_ENTER);
+    expectScreen("Offset save", "Temp offset:    ", "  -1" DEGREE "C          ");
+}
+
+void runReplaceFan(void) {
+    fanHours[0] = 12;
+    fanBaselines[0] = 25;
+    wornFans = (1 << 0);
+    measureButton("Screen temp gain", BUTTON_NEXT);
+    measureButton("Screen replace fan", BUTTON_NEXT);
+    measureButton("Replace start", BUTTON_ENTER);
+    measureButton("Replace select", BUTTON_NEXT);
+    expectScreen("Replace select", "Replace fan:    ", "\x7E Fan 1         ");
+    measureButton("Replace save", BUTTON_ENTER);
+    expectScreen("Replace save", "Replace fan:    ", "  Fan 1         ");
+    if (fanHours[0] != 0 || fanBaselines[0] != 0xFF || wornFans != 0) {
+        printf("FAIL Replace save, fan 1 runtime and health were not reset\n");
+        failureAmount += 1;
+    }
+    measureButton("Screen main", BUTTON_NEXT);
+    measureButton("Screen replace fan", BUTTON_PREV);
+    expectScreen("Screen replace fan", "Replace fan:    ", "  None          ");
+}
+
+int main(int argc, const char *argv[]) {
+    simResetRegisters();
+    // Buttons are pulled up while not pressed.
+    PIND |= (1 << PIND5) | (1 << PIND6) | (1 << PIND7);
+    initializeLcdModel();
+    initializePinModes();
+    initializeTunables();
+    initializeTimer();
+    printf("%-22s %5s %5s %5s %5s %9s %9s\n", "Render", "Cmds", "Chars", "Glyph",
+        "Moves", "Busy ms", "Total ms");
+    runStartup();
+    runMainScreen();
+    runHistoryScreen();
+    runTunableScreens();
+    runTunableEdit();
+    runCalibrationEdit();
+    runReplaceFan();
+    if (failureAmount > 0) {
+        printf("%u checks failed.\n", failureAmount);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
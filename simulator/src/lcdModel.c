@@ -0,0 +1,165 @@
+
+#include <string.h>
+#include <avr/io.h>
+#include "avrModel.h"
+#include "lcdModel.h"
+
+// Execution times of ST7036 instructions with 380 kHz oscillator.
+#define SHORT_BUSY_DURATION (26300ULL)
+#define LONG_BUSY_DURATION (1080 * SIM_MICROSECOND)
+#define DDRAM_SIZE 0x80
+#define ROW_ADDRESS_OFFSET 0x40
+#define ROW_ADDRESS_LENGTH 0x28
+
+lcdStats_t lcdStats;
+uint8_t lcdCgram[SIM_CGRAM_SIZE];
+uint8_t ddram[DDRAM_SIZE];
+uint8_t lcdAddress = 0;
+uint8_t addressIsCgram = false;
+uint8_t addressIncrements = true;
+uint8_t instructionTable = 0;
+uint8_t displayIsOn = false;
+uint8_t shiftRegister = 0;
+uint8_t bitCount = 0;
+uint8_t lastLcdSck = 1;
+uint64_t busyEndTime = 0;
+
+void resetLcd(void) {
+    memset(ddram, ' ', sizeof(ddram));
+    lcdAddress = 0;
+    addressIsCgram = false;
+    addressIncrements = true;
+    instructionTable = 0;
+    displayIsOn = false;
+    bitCount = 0;
+}
+
+void advanceDdramAddress(void) {
+    uint8_t row = lcdAddress / ROW_ADDRESS_OFFSET;
+    uint8_t column = lcdAddress % ROW_ADDRESS_OFFSET;
+    if (addressIncrements) {
+        column += 1;
+        if (column >= ROW_ADDRESS_LENGTH) {
+            column = 0;
+            row = 1 - row;
+        }
+    } else if (column == 0) {
+        column = ROW_ADDRESS_LENGTH - 1;
+        row = 1 - row;
+    } else {
+        column -= 1;
+    }
+    lcdAddress = row * ROW_ADDRESS_OFFSET + column;
+}
+
+void writeLcdData(uint8_t data) {
+    lcdStats.characterAmount += 1;
+    if (addressIsCgram) {
+        lcdStats.glyphByteAmount += 1;
+        lcdCgram[lcdAddress % SIM_CGRAM_SIZE] = data;
+        lcdAddress = (lcdAddress + (addressIncrements ? 1 : -1)) % SIM_CGRAM_SIZE;
+    } else {
+        ddram[lcdAddress % DDRAM_SIZE] = data;
+        advanceDdramAddress();
+    }
+}
+
+// Returns the execution time of the instruction.
+uint64_t executeLcdCommand(uint8_t command) {
+    lcdStats.commandAmount += 1;
+    if (command & 0x80) {
+        lcdAddress = command & 0x7F;
+        addressIsCgram = false;
+        lcdStats.cursorMoveAmount += 1;
+    } else if (command & 0x40) {
+        // Other instruction tables set icons, power, and contrast.
+        if (instructionTable == 0) {
+            lcdAddress = command & 0x3F;
+            addressIsCgram = true;
+        }
+    } else if (command & 0x20) {
+        instructionTable = command & 0x03;
+    } else if (command & 0x10) {
+        // Other instruction tables set bias and double height position.
+        if (instructionTable == 0 && !(command & 0x08)) {
+            uint8_t lastIncrements = addressIncrements;
+            addressIncrements = ((command & 0x04) > 0);
+            advanceDdramAddress();
+            addressIncrements = lastIncrements;
+            lcdStats.cursorMoveAmount += 1;
+        }
+    } else if (command & 0x08) {
+        displayIsOn = ((command & 0x04) > 0);
+    } else if (command & 0x04) {
+        addressIncrements = ((command & 0x02) > 0);
+    } else if (command & 0x02) {
+        lcdAddress = 0;
+        addressIsCgram = false;
+        return LONG_BUSY_DURATION;
+    } else if (command & 0x01) {
+        memset(ddram, ' ', sizeof(ddram));
+        lcdAddress = 0;
+        addressIsCgram = false;
+        addressIncrements = true;
+        lcdStats.clearAmount += 1;
+        return LONG_BUSY_DURATION;
+    }
+    return SHORT_BUSY_DURATION;
+}
+
+void receiveLcdByte(uint8_t data, uint8_t isData) {
+    if (simTime < busyEndTime) {
+        lcdStats.busyViolationAmount += 1;
+    }
+    uint64_t duration = SHORT_BUSY_DURATION;
+    if (isData) {
+        writeLcdData(data);
+    } else {
+        duration = executeLcdCommand(data);
+    }
+    lcdStats.busyTime += duration;
+    busyEndTime = simTime + duration;
+}
+
+void runLcd(void) {
+    if (!(PORTB & (1 << PORTB6))) {
+        resetLcd();
+        return;
+    }
+    uint8_t sck = (PORTB >> PORTB5) & 1;
+    if (PORTB & (1 << PORTB7)) {
+        // Chip select is inactive.
+        bitCount = 0;
+        lastLcdSck = sck;
+        return;
+    }
+    if (sck && !lastLcdSck) {
+        shiftRegister = (shiftRegister << 1) | ((PORTB >> PORTB3) & 1);
+        bitCount += 1;
+        if (bitCount >= 8) {
+            receiveLcdByte(shiftRegister, (PORTB >> PORTB4) & 1);
+            bitCount = 0;
+        }
+    }
+    lastLcdSck = sck;
+}
+
+void initializeLcdModel(void) {
+    resetLcd();
+    memset(lcdCgram, 0, sizeof(lcdCgram));
+    resetLcdStats();
+    simAddDevice(&runLcd);
+}
+
+void resetLcdStats(void) {
+    memset(&lcdStats, 0, sizeof(lcdStats));
+}
+
+uint8_t lcdIsOn(void) {
+    return displayIsOn;
+}
+
+void getLcdRow(uint8_t row, uint8_t *text) {
+    memcpy(text, ddram + row * ROW_ADDRESS_OFFSET, SIM_LCD_WIDTH);
+    text[SIM_LCD_WIDTH] = 0;
+}
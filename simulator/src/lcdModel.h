@@ -0,0 +1,39 @@
+
+// DOGM162 display with ST7036 controller, attached to the SPI pins of the
+// main microcontroller. Decodes the instruction stream into screen contents.
+
+#ifndef LCD_MODEL_H
+#define LCD_MODEL_H
+
+#include <stdint.h>
+
+#define SIM_LCD_WIDTH 16
+#define SIM_LCD_HEIGHT 2
+#define SIM_CGRAM_SIZE 64
+
+typedef struct {
+    uint32_t commandAmount;
+    uint32_t characterAmount;
+    // Characters written to custom character memory.
+    uint32_t glyphByteAmount;
+    // Commands which set the DDRAM address or shift the cursor.
+    uint32_t cursorMoveAmount;
+    uint32_t clearAmount;
+    // Nanoseconds during which the controller executed instructions.
+    uint64_t busyTime;
+    // Bytes received before the previous instruction finished.
+    uint32_t busyViolationAmount;
+} lcdStats_t;
+
+extern lcdStats_t lcdStats;
+extern uint8_t lcdCgram[SIM_CGRAM_SIZE];
+
+void initializeLcdModel(void);
+void resetLcdStats(void);
+// Returns whether the display has been switched on.
+uint8_t lcdIsOn(void);
+// Copies the visible characters of the row into `text`,
+// which must have room for SIM_LCD_WIDTH + 1 bytes.
+void getLcdRow(uint8_t row, uint8_t *text);
+
+#endif
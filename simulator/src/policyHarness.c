@@ -0,0 +1,407 @@
+
+// Replays radiator temperature traces through the main board firmware,
+// and reports how well the fan control policy performs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "avrModel.h"
+#include "satelliteModel.h"
+#include "fanModel.h"
+
+#define main firmwareMain
+#include "../../mainBoard/src/main.c"
+#undef main
+
+#define MAX_TRACE_LENGTH 100000
+#define MAX_BOILER_START_AMOUNT 10000
+// Trace temperature must rise this much within 2 minutes to detect a boiler start.
+#define BOILER_RISE_DELTA 1.0
+#define MIN_BOILER_CYCLE 10
+// Spikes without a boiler start during this many previous minutes are false positives.
+#define SPIKE_WINDOW 15
+
+typedef struct {
+    double ambient;
+    // Fraction of temperature above ambient removed per minute by all fans.
+    double fanCooling;
+    // Fraction of the fan temperature drop which recovers per minute.
+    double recovery;
+    uint8_t shouldPrintCsv;
+} options_t;
+
+options_t options = {20.0, 0.02, 0.1, false};
+const char *tracePath = NULL;
+double traceMinutes[MAX_TRACE_LENGTH];
+double traceTemperatures[MAX_TRACE_LENGTH][SIM_MAX_SATELLITE_AMOUNT];
+uint32_t traceLength = 0;
+uint8_t traceColumnAmount = 0;
+uint32_t traceIndex = 0;
+
+double boilerStarts[MAX_BOILER_START_AMOUNT];
+uint32_t boilerStartAmount = 0;
+
+jmp_buf finishJump;
+uint64_t startTime;
+uint64_t nextSecondTime = 0;
+double coolingOffsets[SIM_MAX_SATELLITE_AMOUNT];
+
+uint32_t nextBoilerStart = 0;
+uint8_t isWaitingForFans = false;
+double waitStartMinute;
+double totalFanOnDelay = 0;
+double maxFanOnDelay = 0;
+uint32_t fanOnAmount = 0;
+uint32_t missedStartAmount = 0;
+uint64_t fanSeconds = 0;
+// Seconds after power on until the first fan runs.
+int32_t firstFanSecond = -1;
+uint32_t cycleAmount = 0;
+uint8_t lastFanAmount = 0;
+uint8_t lastRunStateSample = RUN_STATE_OFF;
+uint32_t spikeAmount = 0;
+uint32_t falseSpikeAmount = 0;
+uint32_t prestartAmount = 0;
+
+void exitWithUsage(void) {
+    fprintf(stderr,
+        "Usage: policyHarness [options] trace.csv\n"
+        "       policyHarness --generate hours period heatMinutes [jitter seed]\n"
+        "Firmware tunables:\n"
+        "  --off C --on C --stage N OFF ON\n"
+        "  --spike-width M --spike-height C --spike-reset M\n"
+        "  --prestart-lead M --aggregate hottest|average\n"
+        "Model:\n"
+        "  --ambient C --fan-cooling F --recovery F --broken-fan N --cable-delay US\n"
+        "Output:\n"
+        "  --csv\n");
+    exit(1);
+}
+
+double getTraceTemperature(uint8_t column, double minute) {
+    while (traceIndex + 1 < traceLength && traceMinutes[traceIndex + 1] <= minute) {
+        traceIndex += 1;
+    }
+    while (traceIndex > 0 && traceMinutes[traceIndex] > minute) {
+        traceIndex -= 1;
+    }
+    if (traceIndex + 1 >= traceLength || minute <= traceMinutes[traceIndex]) {
+        return traceTemperatures[traceIndex][column];
+    }
+    double startMinute = traceMinutes[traceIndex];
+    double endMinute = traceMinutes[traceIndex + 1];
+    double fraction = (minute - startMinute) / (endMinute - startMinute);
+    double startTemperature = traceTemperatures[traceIndex][column];
+    double endTemperature = traceTemperatures[traceIndex + 1][column];
+    return startTemperature + (endTemperature - startTemperature) * fraction;
+}
+
+double getHottestTraceTemperature(double minute) {
+    double output = getTraceTemperature(0, minute);
+    for (uint8_t column = 1; column < traceColumnAmount; column++) {
+        double temperature = getTraceTemperature(column, minute);
+        if (temperature > output) {
+            output = temperature;
+        }
+    }
+    return output;
+}
+
+void loadTrace(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open %s\n", path);
+        exit(1);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (traceLength >= MAX_TRACE_LENGTH) {
+            fprintf(stderr, "Trace is too long.\n");
+            exit(1);
+        }
+        char *text = line;
+        char *end;
+        double minute = strtod(text, &end);
+        if (end == text) {
+            // Header line.
+            continue;
+        }
+        uint8_t columnAmount = 0;
+        while (*end == ',') {
+            if (columnAmount >= MAX_SATELLITE_AMOUNT || columnAmount >= SIM_MAX_SATELLITE_AMOUNT) {
+                fprintf(stderr, "Line %u of %s has more than %u satellites.\n",
+                    traceLength + 1, path, MAX_SATELLITE_AMOUNT);
+                exit(1);
+            }
+            text = end + 1;
+            traceTemperatures[traceLength][columnAmount] = strtod(text, &end);
+            columnAmount += 1;
+        }
+        if (columnAmount == 0) {
+            fprintf(stderr, "Missing temperature on line %u of %s\n", traceLength + 1, path);
+            exit(1);
+        }
+        if (traceColumnAmount == 0) {
+            traceColumnAmount = columnAmount;
+        }
+        traceMinutes[traceLength] = minute;
+        traceLength += 1;
+    }
+    fclose(file);
+    if (traceLength < 2) {
+        fprintf(stderr, "Trace %s has fewer than 2 rows.\n", path);
+        exit(1);
+    }
+}
+
+void detectBoilerStarts(void) {
+    uint8_t wasRising = false;
+    double lastStart = -MIN_BOILER_CYCLE;
+    double endMinute = traceMinutes[traceLength - 1];
+    for (double minute = traceMinutes[0]; minute + 2 <= endMinute; minute += 1) {
+        double delta = getHottestTraceTemperature(minute + 2) - getHottestTraceTemperature(minute);
+        uint8_t isRising = (delta >= BOILER_RISE_DELTA);
+        if (isRising && !wasRising && minute - lastStart >= MIN_BOILER_CYCLE
+                && boilerStartAmount < MAX_BOILER_START_AMOUNT) {
+            boilerStarts[boilerStartAmount] = minute;
+            boilerStartAmount += 1;
+            lastStart = minute;
+        }
+        wasRising = isRising;
+    }
+    traceIndex = 0;
+}
+
+uint8_t hasRecentBoilerStart(double minute) {
+    for (uint32_t index = 0; index < boilerStartAmount; index++) {
+        double start = boilerStarts[index];
+        if (start <= minute && start >= minute - SPIKE_WINDOW) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void updateThermalModel(uint8_t fanAmount) {
+    double minute = (double)simTime / (60 * SIM_SECOND);
+    double fanFraction = (double)fanAmount / SIM_FAN_AMOUNT;
+    for (uint8_t column = 0; column < traceColumnAmount; column++) {
+        double traceTemperature = getTraceTemperature(column, minute);
+        double excess = traceTemperature - coolingOffsets[column] - options.ambient;
+        if (excess < 0) {
+            excess = 0;
+        }
+        double change = options.fanCooling * fanFraction * excess
+            - options.recovery * coolingOffsets[column];
+        coolingOffsets[column] += change / 60;
+        setSatelliteTemperature(column, traceTemperature - coolingOffsets[column]);
+    }
+}
+
+void updateMetrics(uint8_t fanAmount) {
+    double minute = (double)simTime / (60 * SIM_SECOND);
+    fanSeconds += fanAmount;
+    if (firstFanSecond < 0 && fanAmount > 0) {
+        firstFanSecond = (int32_t)((simTime - startTime) / SIM_SECOND);
+    }
+    if (lastFanAmount == 0 && fanAmount > 0) {
+        cycleAmount += 1;
+    }
+    lastFanAmount = fanAmount;
+    while (nextBoilerStart < boilerStartAmount && boilerStarts[nextBoilerStart] <= minute) {
+        if (isWaitingForFans) {
+            missedStartAmount += 1;
+        }
+        isWaitingForFans = true;
+        waitStartMinute = boilerStarts[nextBoilerStart];
+        nextBoilerStart += 1;
+    }
+    if (isWaitingForFans && fanAmount > 0) {
+        double delay = minute - waitStartMinute;
+        totalFanOnDelay += delay;
+        if (delay > maxFanOnDelay) {
+            maxFanOnDelay = delay;
+        }
+        fanOnAmount += 1;
+        isWaitingForFans = false;
+    }
+    if (runState != lastRunStateSample) {
+        if (runState == RUN_STATE_SPIKE) {
+            spikeAmount += 1;
+            if (!hasRecentBoilerStart(minute)) {
+                falseSpikeAmount += 1;
+            }
+        } else if (runState == RUN_STATE_PRESTART) {
+            prestartAmount += 1;
+        }
+        lastRunStateSample = runState;
+    }
+}
+
+// Runs as a simulated device once per simulated second.
+void runHarness(void) {
+    if (simTime < nextSecondTime) {
+        return;
+    }
+    nextSecondTime += SIM_SECOND;
+    if ((double)simTime / (60 * SIM_SECOND) >= traceMinutes[traceLength - 1]) {
+        longjmp(finishJump, 1);
+    }
+    uint8_t fanAmount = getRunningFanAmount();
+    updateThermalModel(fanAmount);
+    updateMetrics(fanAmount);
+}
+
+void printReport(void) {
+    double meanDelay = (fanOnAmount > 0) ? totalFanOnDelay / fanOnAmount : 0;
+    if (isWaitingForFans) {
+        missedStartAmount += 1;
+    }
+    double fanMinutes = (double)fanSeconds / 60;
+    if (options.shouldPrintCsv) {
+        printf("%s,%u,%.2f,%.2f,%u,%.1f,%d,%u,%u,%u,%u,%u\n", tracePath, boilerStartAmount,
+            meanDelay, maxFanOnDelay, missedStartAmount, fanMinutes, firstFanSecond, cycleAmount,
+            spikeAmount, falseSpikeAmount, prestartAmount,
+            pgm_read_byte(linkHalfPeriods + linkLevel) * LINK_STEP_TIME);
+        return;
+    }
+    printf("Trace: %s (%.0f minutes, satellites: %u)\n", tracePath,
+        traceMinutes[traceLength - 1] - traceMinutes[0], traceColumnAmount);
+    printf("Boiler starts: %u\n", boilerStartAmount);
+    printf("Time to fan on: mean %.2f min, max %.2f min, missed %u\n",
+        meanDelay, maxFanOnDelay, missedStartAmount);
+    printf("Fan minutes: %.1f\n", fanMinutes);
+    printf("First fan on: %d s after power on\n", firstFanSecond);
+    printf("Start/stop cycles: %u\n", cycleAmount);
+    printf("Spikes: %u (false positives: %u)\n", spikeAmount, falseSpikeAmount);
+    printf("Prestarts: %u\n", prestartAmount);
+    printf("Link half-period: %u us\n",
+        pgm_read_byte(linkHalfPeriods + linkLevel) * LINK_STEP_TIME);
+}
+
+// Prints a trace of a radiator heated by a boiler which runs for `heatMinutes`
+// every `period` minutes, without any fans.
+void generateTrace(double hours, double period, double heatMinutes, double jitter, uint32_t seed) {
+    srand(seed);
+    double temperature = options.ambient;
+    double cycleStart = 0;
+    double cyclePeriod = period;
+    printf("minute,temperature\n");
+    for (uint32_t minute = 0; minute <= hours * 60; minute++) {
+        if (minute - cycleStart >= cyclePeriod) {
+            cycleStart = minute;
+            cyclePeriod = period + jitter * (2.0 * rand() / RAND_MAX - 1.0);
+        }
+        if (minute - cycleStart < heatMinutes) {
+            temperature += (70.0 - temperature) / 8.0;
+        } else {
+            temperature += (options.ambient - temperature) / 45.0;
+        }
+        double noise = 0.2 * (2.0 * rand() / RAND_MAX - 1.0);
+        printf("%u,%.1f\n", minute, temperature + noise);
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    simResetRegisters();
+    // Buttons are pulled up while not pressed.
+    PIND |= (1 << PIND5) | (1 << PIND6) | (1 << PIND7);
+    int8_t brokenFan = -1;
+    // Firmware ignores a stage when either of its thresholds is missing.
+    for (uint8_t stage = 0; stage < STAGE_AMOUNT; stage++) {
+        uint8_t address = getStageThresholdAddress(stage);
+        simEeprom[address] = pgm_read_byte(defaultStageThresholds + stage * 2);
+        simEeprom[address + 1] = pgm_read_byte(defaultStageThresholds + stage * 2 + 1);
+    }
+    for (int index = 1; index < argc; index++) {
+        const char *name = argv[index];
+        uint8_t hasValue = (index + 1 < argc);
+        const char *value = hasValue ? argv[index + 1] : NULL;
+        if (strcmp(name, "--generate") == 0) {
+            if (index + 3 >= argc) {
+                exitWithUsage();
+            }
+            double jitter = (index + 4 < argc) ? atof(argv[index + 4]) : 0;
+            uint32_t seed = (index + 5 < argc) ? atoi(argv[index + 5]) : 1;
+            generateTrace(atof(argv[index + 1]), atof(argv[index + 2]),
+                atof(argv[index + 3]), jitter, seed);
+            return 0;
+        } else if (strcmp(name, "--csv") == 0) {
+            options.shouldPrintCsv = true;
+            continue;
+        } else if (name[0] != '-') {
+            tracePath = name;
+            continue;
+        }
+        if (!hasValue) {
+            exitWithUsage();
+        }
+        index += 1;
+        if (strcmp(name, "--stage") == 0) {
+            if (index + 2 >= argc) {
+                exitWithUsage();
+            }
+            uint8_t stage = atoi(value) - 1;
+            if (stage >= STAGE_AMOUNT) {
+                exitWithUsage();
+            }
+            uint8_t address = getStageThresholdAddress(stage);
+            simEeprom[address] = atoi(argv[index + 1]);
+            simEeprom[address + 1] = atoi(argv[index + 2]);
+            index += 2;
+        } else if (strcmp(name, "--off") == 0) {
+            simEeprom[ADDRESS_OFF_THRESHOLD] = atoi(value);
+        } else if (strcmp(name, "--on") == 0) {
+            simEeprom[ADDRESS_ON_THRESHOLD] = atoi(value);
+        } else if (strcmp(name, "--spike-width") == 0) {
+            simEeprom[ADDRESS_SPIKE_WIDTH] = atoi(value);
+        } else if (strcmp(name, "--spike-height") == 0) {
+            simEeprom[ADDRESS_SPIKE_HEIGHT] = atoi(value);
+        } else if (strcmp(name, "--spike-reset") == 0) {
+            simEeprom[ADDRESS_SPIKE_RESET] = atoi(value);
+        } else if (strcmp(name, "--prestart-lead") == 0) {
+            simEeprom[ADDRESS_PRESTART_LEAD] = atoi(value);
+        } else if (strcmp(name, "--aggregate") == 0) {
+            uint8_t isAverage = (strcmp(value, "average") == 0);
+            simEeprom[ADDRESS_AGGREGATE] = isAverage ? AGGREGATE_AVERAGE : AGGREGATE_HOTTEST;
+        } else if (strcmp(name, "--ambient") == 0) {
+            options.ambient = atof(value);
+        } else if (strcmp(name, "--fan-cooling") == 0) {
+            options.fanCooling = atof(value);
+        } else if (strcmp(name, "--recovery") == 0) {
+            options.recovery = atof(value);
+        } else if (strcmp(name, "--cable-delay") == 0) {
+            setCableDelay((uint64_t)(atof(value) * SIM_MICROSECOND));
+        } else if (strcmp(name, "--broken-fan") == 0) {
+            brokenFan = atoi(value) - 1;
+        } else {
+            exitWithUsage();
+        }
+    }
+    if (tracePath == NULL) {
+        exitWithUsage();
+    }
+    loadTrace(tracePath);
+    detectBoilerStarts();
+    simEeprom[ADDRESS_SATELLITE_AMOUNT] = traceColumnAmount;
+    initializeSatelliteModel(traceColumnAmount);
+    initializeFanModel();
+    if (brokenFan >= 0) {
+        breakFan(brokenFan);
+    }
+    simAddDevice(&runHarness);
+    // Simulation starts at the first minute of the trace.
+    simTime = (uint64_t)(traceMinutes[0] * 60 * SIM_SECOND);
+    startTime = simTime;
+    nextSecondTime = simTime;
+    updateThermalModel(0);
+    if (setjmp(finishJump) == 0) {
+        firmwareMain();
+    }
+    printReport();
+    return 0;
+}
@@ -0,0 +1,32 @@
+
+// Compiles satelliteBoard/src/main.c with its own registers. The build
+// makes one copy of this file for each simulated satellite, in which
+// every symbol except `satelliteInstance` is local.
+
+#include "satelliteInstance.h"
+
+#define main satelliteMain
+#include "../../satelliteBoard/src/main.c"
+#undef main
+
+uint8_t DDRB, PORTB, PINB;
+uint8_t TCCR0B, TCNT0, TIFR0;
+uint8_t ADMUX, ADCSRA;
+uint16_t ADC;
+uint8_t satelliteEeprom[SATELLITE_EEPROM_SIZE];
+
+uint8_t eeprom_read_byte(const uint8_t *address) {
+    return satelliteEeprom[(uintptr_t)address % SATELLITE_EEPROM_SIZE];
+}
+
+satelliteInstance_t satelliteInstance = {
+    &PINB,
+    &DDRB,
+    &PORTB,
+    &TCNT0,
+    &TIFR0,
+    &ADC,
+    satelliteEeprom,
+    &initializeSatellite,
+    &pollSatellite
+};
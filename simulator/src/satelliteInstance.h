@@ -0,0 +1,24 @@
+
+// Registers and entry points of one copy of the satellite firmware.
+
+#ifndef SATELLITE_INSTANCE_H
+#define SATELLITE_INSTANCE_H
+
+#include <stdint.h>
+
+// ATtiny13A has 64 bytes of EEPROM.
+#define SATELLITE_EEPROM_SIZE 64
+
+typedef struct {
+    uint8_t *pinB;
+    uint8_t *ddrB;
+    uint8_t *portB;
+    uint8_t *tcnt0;
+    uint8_t *tifr0;
+    uint16_t *adc;
+    uint8_t *eeprom;
+    void (*initialize)(void);
+    void (*poll)(void);
+} satelliteInstance_t;
+
+#endif
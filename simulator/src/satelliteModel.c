@@ -0,0 +1,121 @@
+
+#include <avr/io.h>
+#include "avrModel.h"
+#include "satelliteModel.h"
+#include "satelliteInstance.h"
+
+// Satellite timer ticks every 256 clock cycles, and overflows every 256 ticks.
+#define TIMER_TICKS_PER_SECOND (SATELLITE_F_CPU / 256)
+// Satellites compare 8-bit timer values, so they must poll well within
+// each timer overflow, as they do while looping on real hardware.
+#define MAX_POLL_INTERVAL (100 * SIM_MICROSECOND)
+
+// Each satellite runs its own copy of the satellite firmware.
+extern satelliteInstance_t satelliteInstance0;
+extern satelliteInstance_t satelliteInstance1;
+extern satelliteInstance_t satelliteInstance2;
+extern satelliteInstance_t satelliteInstance3;
+
+satelliteInstance_t *satelliteInstances[SIM_MAX_SATELLITE_AMOUNT] = {
+    &satelliteInstance0, &satelliteInstance1, &satelliteInstance2, &satelliteInstance3
+};
+double modelTemperatures[SIM_MAX_SATELLITE_AMOUNT];
+uint8_t modelSatelliteAmount = 0;
+uint64_t lastPollTime = 0;
+uint64_t lastTimerOverflow = 0;
+// Cable delays changes of the data line by this many nanoseconds.
+uint64_t cableDelay = 0;
+uint8_t cableData = 1;
+uint8_t pendingCableData = 1;
+uint64_t cableChangeTime = 0;
+
+uint16_t getAdcValue(double temperature) {
+    // TMP36 outputs 500 mV at 0 degrees C, and 10 mV per degree C.
+    // ADC reference is 5 V.
+    double voltage = 0.5 + temperature * 0.01;
+    double value = voltage / 5.0 * 1024.0 + 0.5;
+    if (value < 0) {
+        return 0;
+    }
+    if (value > 1023) {
+        return 1023;
+    }
+    return (uint16_t)value;
+}
+
+uint64_t getTimerTicks(uint64_t time) {
+    return time / SIM_MICROSECOND * TIMER_TICKS_PER_SECOND / 1000000;
+}
+
+void pollSatellites(uint64_t time) {
+    uint64_t timerTicks = getTimerTicks(time);
+    uint64_t timerOverflow = timerTicks >> 8;
+    uint8_t hasOverflow = (timerOverflow != lastTimerOverflow);
+    lastTimerOverflow = timerOverflow;
+    lastPollTime = time;
+    for (uint8_t address = 0; address < modelSatelliteAmount; address++) {
+        satelliteInstance_t *instance = satelliteInstances[address];
+        *(instance->tcnt0) = (uint8_t)timerTicks;
+        // Firmware clears the overflow flag during the same poll.
+        *(instance->tifr0) = hasOverflow ? (1 << TOV0) : 0;
+        *(instance->adc) = getAdcValue(modelTemperatures[address]);
+        instance->poll();
+    }
+}
+
+void runSatellites(void) {
+    // SCK kept its previous value until now.
+    while (simTime - lastPollTime > MAX_POLL_INTERVAL) {
+        pollSatellites(lastPollTime + MAX_POLL_INTERVAL);
+    }
+    // SCK is an output of the main board, and idles high.
+    uint8_t sck = (DDRD & (1 << DDD3)) ? ((PORTD >> PORTD3) & 1) : 1;
+    for (uint8_t address = 0; address < modelSatelliteAmount; address++) {
+        simSetPin(satelliteInstances[address]->pinB, PINB4, sck);
+    }
+    pollSatellites(simTime);
+    // Data line is pulled up when no satellite drives the line.
+    uint8_t data = 1;
+    for (uint8_t address = 0; address < modelSatelliteAmount; address++) {
+        satelliteInstance_t *instance = satelliteInstances[address];
+        if (*(instance->ddrB) & (1 << DDB1)) {
+            data = (*(instance->portB) >> PORTB1) & 1;
+        }
+    }
+    if (data != pendingCableData) {
+        pendingCableData = data;
+        cableChangeTime = simTime;
+    }
+    if (simTime - cableChangeTime >= cableDelay) {
+        cableData = pendingCableData;
+    }
+    simSetPin(&PIND, PIND4, cableData);
+}
+
+void initializeSatelliteModel(uint8_t satelliteAmount) {
+    if (satelliteAmount > SIM_MAX_SATELLITE_AMOUNT) {
+        satelliteAmount = SIM_MAX_SATELLITE_AMOUNT;
+    }
+    modelSatelliteAmount = satelliteAmount;
+    lastPollTime = simTime;
+    lastTimerOverflow = getTimerTicks(simTime) >> 8;
+    for (uint8_t address = 0; address < satelliteAmount; address++) {
+        satelliteInstance_t *instance = satelliteInstances[address];
+        modelTemperatures[address] = 20;
+        instance->eeprom[0] = address;
+        simSetPin(instance->pinB, PINB4, 1);
+        *(instance->tcnt0) = (uint8_t)getTimerTicks(simTime);
+        instance->initialize();
+    }
+    simAddDevice(&runSatellites);
+}
+
+void setSatelliteTemperature(uint8_t satellite, double temperature) {
+    if (satellite < modelSatelliteAmount) {
+        modelTemperatures[satellite] = temperature;
+    }
+}
+
+void setCableDelay(uint64_t nanoseconds) {
+    cableDelay = nanoseconds;
+}
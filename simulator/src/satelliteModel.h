@@ -0,0 +1,18 @@
+
+// Satellite boards on the SCK and data lines of the main microcontroller.
+// Each satellite runs the firmware in satelliteBoard/src/main.c.
+
+#ifndef SATELLITE_MODEL_H
+#define SATELLITE_MODEL_H
+
+#include <stdint.h>
+
+#define SIM_MAX_SATELLITE_AMOUNT 4
+
+void initializeSatelliteModel(uint8_t satelliteAmount);
+// Sets the temperature measured by the given satellite in degrees C.
+void setSatelliteTemperature(uint8_t satellite, double temperature);
+// Models a long cable which delays changes of the data line.
+void setCableDelay(uint64_t nanoseconds);
+
+#endif